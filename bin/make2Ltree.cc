@@ -8,11 +8,14 @@
 #include "TF1.h"
 #include "TRandom3.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
 
-#include "HeavyIonsAnalysis/topskim/include/tnp_weight.h"
-#include "HeavyIonsAnalysis/topskim/include/tnp_electrons.h"
+#include "HeavyIonsAnalysis/topskim/include/ScaleFactorService.h"
+#include "HeavyIonsAnalysis/topskim/include/CentralityContext.h"
+#include "HeavyIonsAnalysis/topskim/include/TopMassReweighter.h"
+#include "HeavyIonsAnalysis/topskim/include/QuenchingSampler.h"
 #include "HeavyIonsAnalysis/topskim/include/ForestHiTree.h"
 #include "HeavyIonsAnalysis/topskim/include/ForestHLTObject.h"
 #include "HeavyIonsAnalysis/topskim/include/ForestLeptons.h"
@@ -20,9 +23,17 @@
 #include "HeavyIonsAnalysis/topskim/include/ForestPFCands.h"
 #include "HeavyIonsAnalysis/topskim/include/ForestJets.h"
 #include "HeavyIonsAnalysis/topskim/include/JetCorrector.h"
+#include "HeavyIonsAnalysis/topskim/include/JetCorrectorTable.h"
 #include "HeavyIonsAnalysis/topskim/include/JetUncertainty.h"
+#include "HeavyIonsAnalysis/topskim/include/JetUncertaintySources.h"
+#include "HeavyIonsAnalysis/topskim/include/JetCalibrationCache.h"
 #include "HeavyIonsAnalysis/topskim/include/LumiRun.h"
 #include "HeavyIonsAnalysis/topskim/include/HistTool.h"
+#include "HeavyIonsAnalysis/topskim/include/OutputArray.h"
+#include "HeavyIonsAnalysis/topskim/include/MEWeightCompressor.h"
+#include "HeavyIonsAnalysis/topskim/include/OutputPolicy.h"
+#include "HeavyIonsAnalysis/topskim/include/RNTupleOutput.h"
+#include "HeavyIonsAnalysis/topskim/include/SystematicsOutput.h"
 #include "HeavyIonsAnalysis/topskim/include/PFAnalysis.h"
 #include "HeavyIonsAnalysis/topskim/include/LeptonSummary.h"
 #include "HeavyIonsAnalysis/topskim/include/ForestGen.h"
@@ -96,57 +107,23 @@ int getRhoIndex(float eta,std::vector<Double_t> *etaMin=NULL, std::vector<Double
 
 TRandom3 * smearRand = new TRandom3(42);
 
-float calibratedPt(float pt, float eta, float cen, bool isMC) {
-
-  float newpt;
-  float scale = 0.;
-  //https://twiki.cern.ch/twiki/pub/CMS/HiEgamma2019/electron-aa-scalesmear-190918.pdf
-  if (isMC){
-    if (fabs(eta) < 1.45) {
-      if      (cen < 10.) scale = 0.971;
-      else if (cen < 30.) scale = 0.990;
-      else                scale = 1.003;
-    }else {
-      if      (cen < 10.) scale = 0.910;
-      else if (cen < 30.) scale = 0.951;
-      else                scale = 0.988;
-    }
-  } else {
-    if (fabs(eta) < 1.45) {
-      if      (cen < 10.) scale = 0.989;
-      else if (cen < 30.) scale = 1.006;
-      else                scale = 1.016;
-    }else {
-      if      (cen < 10.) scale = 0.967;
-      else if (cen < 30.) scale = 1.018;
-      else                scale = 1.054;
-    }
-  }
-
-  newpt = pt * scale;
-
-  float smear = 1.;
-
-  if (isMC){
-    if (fabs(eta) < 1.45) {
-      if      (cen < 10.) smear = 1.19113;
-      else if (cen < 30.) smear = 1.28262;
-      else                smear = 2.20549;
-    } else {
-      if      (cen < 10.) smear = 3.13988;
-      else if (cen < 30.) smear = 3.15340;
-      else                smear = 3.17194;
-    }
-
-    newpt = newpt * smearRand->Gaus(1., smear / 91.1876);
-  }
+//electron energy scale and, in MC, smearing for the centrality of the event
+float calibratedPt(float pt, float eta, const CentralityContext &cen, bool isMC) {
 
+  int ireg(cen.eleRegion(eta));
+  float newpt = pt * cen.eleScale[ireg];
+  if (isMC) newpt = newpt * smearRand->Gaus(1., cen.eleSmear[ireg] / 91.1876);
   return newpt;
 
 }
 
-// index, ntks in svtx, m svtx, csv
-typedef std::tuple<int,int,float,float,TLorentzVector,int,int> BtagInfo_t;
+// kinematics of the gen jet matched to a reco jet (all zero if unmatched)
+struct GenJetKin_t {
+  float pt, eta, phi, m;
+};
+
+// index, ntks in svtx, m svtx, csv, matched gen jet, parton flavor, parton flavor for B
+typedef std::tuple<int,int,float,float,GenJetKin_t,int,int> BtagInfo_t;
 static bool orderByBtagInfo(const BtagInfo_t &a, const BtagInfo_t &b)
 {
   //int ntks_a(std::get<1>(a)), ntks_b(std::get<1>(b));
@@ -157,20 +134,6 @@ static bool orderByBtagInfo(const BtagInfo_t &a, const BtagInfo_t &b)
   return false;
 }
 
-// btag efficiencies from the AN
-float btagEfficiencies(int flavor, float cenbin){
-  if(csvWP==0){
-    if      (fabs(flavor) == 5) return (cenbin <= 30 ? 0.556 : 0.683); // bs
-    else if (fabs(flavor) == 0) return (cenbin <= 30 ? 0.057 : 0.042); // unmatched
-    else                        return (cenbin <= 30 ? 0.023 : 0.008); // udsg
-  }
-  else{
-    if      (fabs(flavor) == 5) return (cenbin <= 30 ? 0.385 : 0.546); // bs
-    else if (fabs(flavor) == 0) return (cenbin <= 30 ? 0.013 : 0.008); // unmatched
-    else                        return (cenbin <= 30 ? 0.005 : 0.001); // udsg
-  }
-}
-
 //
 static bool orderByPt(const LeptonSummary &a, const LeptonSummary &b)
 {
@@ -179,85 +142,118 @@ static bool orderByPt(const LeptonSummary &a, const LeptonSummary &b)
   return false;
 }
 
-//parameterizations from Glauber MC
-Double_t findNcoll(int hiBin) {
-  const int nbins = 200;
-  const Double_t Ncoll[nbins] = {1976.95, 1944.02, 1927.29, 1891.9, 1845.3, 1807.2, 1760.45, 1729.18, 1674.8, 1630.3, 1590.52, 1561.72, 1516.1, 1486.5, 1444.68, 1410.88, 1376.4, 1347.32, 1309.71, 1279.98, 1255.31, 1219.89, 1195.13, 1165.96, 1138.92, 1113.37, 1082.26, 1062.42, 1030.6, 1009.96, 980.229, 955.443, 936.501, 915.97, 892.063, 871.289, 847.364, 825.127, 806.584, 789.163, 765.42, 751.187, 733.001, 708.31, 690.972, 677.711, 660.682, 640.431, 623.839, 607.456, 593.307, 576.364, 560.967, 548.909, 530.475, 519.575, 505.105, 490.027, 478.133, 462.372, 451.115, 442.642, 425.76, 416.364, 405.154, 392.688, 380.565, 371.167, 360.28, 348.239, 340.587, 328.746, 320.268, 311.752, 300.742, 292.172, 281.361, 274.249, 267.025, 258.625, 249.931, 240.497, 235.423, 228.63, 219.854, 214.004, 205.425, 199.114, 193.618, 185.644, 180.923, 174.289, 169.641, 161.016, 157.398, 152.151, 147.425, 140.933, 135.924, 132.365, 127.017, 122.127, 117.817, 113.076, 109.055, 105.16, 101.323, 98.098, 95.0548, 90.729, 87.6495, 84.0899, 80.2237, 77.2201, 74.8848, 71.3554, 68.7745, 65.9911, 63.4136, 61.3859, 58.1903, 56.4155, 53.8486, 52.0196, 49.2921, 47.0735, 45.4345, 43.8434, 41.7181, 39.8988, 38.2262, 36.4435, 34.8984, 33.4664, 31.8056, 30.351, 29.2074, 27.6924, 26.7754, 25.4965, 24.2802, 22.9651, 22.0059, 21.0915, 19.9129, 19.1041, 18.1487, 17.3218, 16.5957, 15.5323, 14.8035, 14.2514, 13.3782, 12.8667, 12.2891, 11.61, 11.0026, 10.3747, 9.90294, 9.42648, 8.85324, 8.50121, 7.89834, 7.65197, 7.22768, 6.7755, 6.34855, 5.98336, 5.76555, 5.38056, 5.11024, 4.7748, 4.59117, 4.23247, 4.00814, 3.79607, 3.68702, 3.3767, 3.16309, 2.98282, 2.8095, 2.65875, 2.50561, 2.32516, 2.16357, 2.03235, 1.84061, 1.72628, 1.62305, 1.48916, 1.38784, 1.28366, 1.24693, 1.18552, 1.16085, 1.12596, 1.09298, 1.07402, 1.06105, 1.02954};
-  return Ncoll[hiBin];
-};
-
-//
-TF1 *getRBW(float m,float g) {
-  //define the relativistic Breit-Wigner function
-  TF1 *bwigner=new TF1("bwigner",
-                       "[0]*([1]*[2]*sqrt([1]*[1]*([1]*[1]+[2]*[2]))/sqrt([1]*[1]+sqrt([1]*[1]*([1]*[1]+[2]*[2]))))/(TMath::Power(x*x-[1]*[1],2)+TMath::Power([1]*[2],2))",
-                       max(float(0.),m-50*g),m+50*g);
-
-  bwigner->SetParName(0,"N");
-  bwigner->SetParameter(0,1.0);
-  bwigner->SetParName(1,"m_{0}");
-  bwigner->FixParameter(1,m);
-  bwigner->SetParName(2,"#Gamma_{t}");
-  bwigner->FixParameter(2,g);
-
-  return bwigner;
+// global tag eras which change the event selection
+enum GTEra { ERA_OTHER=0, ERA_103X, ERA_75X, ERA_75X_MCRUN2 };
+int getGTEra(const std::string &GT)
+{
+  if(GT.find("103X")!=string::npos)       return ERA_103X;
+  if(GT.find("75X_mcRun2")!=string::npos) return ERA_75X_MCRUN2;
+  if(GT.find("75X")!=string::npos)        return ERA_75X;
+  return ERA_OTHER;
 }
 
-//
-float weightBW(TF1 *bwigner,std::vector<float> obsm,float g,float m,float gini,float mini) {
-
-  //
-  if(bwigner==NULL || obsm.size()!=2 || obsm[0]<150 || obsm[1]<150) return 1.;
-
-  bwigner->FixParameter(1,mini);
-  bwigner->FixParameter(2,gini);
-  float nini=bwigner->Integral(max(m-50*g,float(0.)),m+50*g);
-      
-  bwigner->FixParameter(1,m);
-  bwigner->FixParameter(2,g);
-  float n=bwigner->Integral(max(m-50*g,float(0.)),m+50*g);
-
-  float wgt(1.0);
-  for(auto obsm_i : obsm){
-    bwigner->FixParameter(1,mini);
-    bwigner->FixParameter(2,gini);
-    float vini=bwigner->Eval(obsm_i);
+// event loop modes: the loop is instantiated once per mode, chosen at startup,
+// so that the data/MC, pp/PbPb and era flags are compile-time constants in the hot path
+// and the branches which can't be taken in a mode are discarded (if constexpr on the mayBe* flags)
+template<bool MC, bool PP, int ERA>
+struct LoopMode {
+  static constexpr bool specialised=true;
+  static constexpr bool isMC=MC;
+  static constexpr bool isPP=PP;
+  static constexpr int era=ERA;
+  static constexpr bool mayBeMC=MC, mayBeData=!MC, mayBePP=PP, mayBePbPb=!PP;
+  static constexpr bool mayBeEra(int e)    { return e==ERA; }
+  static constexpr bool mayBeNotEra(int e) { return e!=ERA; }
+};
 
-    bwigner->FixParameter(1,m);
-    bwigner->FixParameter(2,g);
-    float v=bwigner->Eval(obsm_i);
+// reference mode for --benchmark-loop: all the branches are kept and the flags are tested at run time
+struct RuntimeLoopMode {
+  static constexpr bool specialised=false;
+  static inline bool isMC=false;
+  static inline bool isPP=false;
+  static inline int era=ERA_OTHER;
+  static constexpr bool mayBeMC=true, mayBeData=true, mayBePP=true, mayBePbPb=true;
+  static constexpr bool mayBeEra(int)    { return true; }
+  static constexpr bool mayBeNotEra(int) { return true; }
+};
 
-    wgt *= (v/n) / (vini/nini);
+template<bool MC, bool PP, typename F>
+void runEventLoop(int era, F &loop)
+{
+  switch(era) {
+  case ERA_103X:       loop(LoopMode<MC,PP,ERA_103X>());       break;
+  case ERA_75X:        loop(LoopMode<MC,PP,ERA_75X>());        break;
+  case ERA_75X_MCRUN2: loop(LoopMode<MC,PP,ERA_75X_MCRUN2>()); break;
+  default:             loop(LoopMode<MC,PP,ERA_OTHER>());      break;
   }
-
-  return wgt;
 }
 
-
+template<typename F>
+void runEventLoop(bool isMC, bool isPP, int era, F &loop)
+{
+  if(isMC) { if(isPP) runEventLoop<true,true>(era,loop);  else runEventLoop<true,false>(era,loop);  }
+  else     { if(isPP) runEventLoop<false,true>(era,loop); else runEventLoop<false,false>(era,loop); }
+}
 
 //
 int main(int argc, char* argv[])
 {
-  TF1 * quenchingModel = new TF1("quenchingModel", "[0]/(TMath::Sqrt(2.*TMath::Pi())*0.73*x)*TMath::Exp(-1.*TMath::Power(TMath::Log(x/[0])+1.5,2)/2./0.73/0.73)", 0., 50.);
+  //log-normal jet energy loss: omega_c (can be made centrality dependent) and the upper edge of the tabulated loss,
+  //the range [0,50] GeV of the original TF1 model, which is independent of omega_c (they only happen to be equal)
+  const double quenchOmegaC(50.);
+  const double quenchTableXmax(50.);
+  QuenchingSampler quenchingModel(quenchTableXmax);
   TF1 * centralityModel = new TF1("centralityModel", "gaus");
   centralityModel->SetParameter(0,  1.090);
   centralityModel->SetParameter(1, -0.144);
   centralityModel->SetParameter(2,  0.442);
 
   bool blind(false);
-  TString inURL,outURL;
-  bool isMC(false),isPP(false),isAMCATNLO(false),isSkim(false);
-  int maxEvents(-1);
+  TString inURL,outURL,jecSourcesURL,outPolicyName("default"),outFormat("ttree"),systList;
+  bool isMC(false),isPP(false),isAMCATNLO(false),isSkim(false),flatBranches(false),reduceHessian(false),packMEWeights(false),benchmarkOutput(false),benchmarkLoop(false);
+  bool flavourJetMaps(false),memoryReport(false);
+  int maxEvents(-1),sparseThreshold(0);
+  float jecTableTol(-1);
   for(int i=1;i<argc;i++){
     string arg(argv[i]);
     if(arg.find("--in")!=string::npos && i+1<argc)         { inURL=TString(argv[i+1]); i++;}
     else if(arg.find("--out")!=string::npos && i+1<argc)   { outURL=TString(argv[i+1]); i++;}
     else if(arg.find("--max")!=string::npos && i+1<argc)   { sscanf(argv[i+1],"%d",&maxEvents); }
     else if(arg.find("--csvWP")!=string::npos && i+1<argc) { sscanf(argv[i+1],"%d",&csvWP); }
+    else if(arg.find("--jecTable")!=string::npos && i+1<argc) { sscanf(argv[i+1],"%f",&jecTableTol); i++; }
+    else if(arg.find("--jecSources")!=string::npos && i+1<argc) { jecSourcesURL=TString(argv[i+1]); i++; }
     else if(arg.find("--mc")!=string::npos)                { isMC=true;  }
     else if(arg.find("--pp")!=string::npos)                { isPP=true;  }
     else if(arg.find("--amcatnlo")!=string::npos)          { isAMCATNLO=true;  }
     else if(arg.find("--skim")!=string::npos)              { isSkim=true;  }
+    else if(arg.find("--flatBranches")!=string::npos)      { flatBranches=true;  }
+    else if(arg.find("--reduceHessian")!=string::npos)     { reduceHessian=true;  }
+    else if(arg.find("--packMEWeights")!=string::npos)     { packMEWeights=true;  }
+    else if(arg.find("--compression")!=string::npos && i+1<argc) { outPolicyName=TString(argv[i+1]); i++; }
+    else if(arg.find("--benchmark-output")!=string::npos)  { benchmarkOutput=true;  }
+    else if(arg.find("--benchmark-loop")!=string::npos)    { benchmarkLoop=true;  }
+    else if(arg.find("--sparseHists")!=string::npos && i+1<argc) { sscanf(argv[i+1],"%d",&sparseThreshold); i++; }
+    else if(arg.find("--flavourJetMaps")!=string::npos)    { flavourJetMaps=true;  }
+    else if(arg.find("--memoryReport")!=string::npos)      { memoryReport=true;  }
+    else if(arg.find("--syst")!=string::npos) {
+      if(arg.find("=")!=string::npos) systList=TString(arg.substr(arg.find("=")+1));
+      else if(i+1<argc)               { systList=TString(argv[i+1]); i++; }
+    }
+    else if(arg.find("--format")!=string::npos) {
+      if(arg.find("=")!=string::npos) outFormat=TString(arg.substr(arg.find("=")+1));
+      else if(i+1<argc)               { outFormat=TString(argv[i+1]); i++; }
+    }
+  }
+
+  //the RNTuple is imported from the tree at the end of the job, with the std::vector branches as collections
+  bool rntupleOutput(outFormat=="rntuple");
+  if(rntupleOutput && !RNTupleOutput::isAvailable()) {
+    cout << "RNTuple output requires ROOT>=6.32, writing a TTree" << endl;
+    rntupleOutput=false;
+  }
+  if(rntupleOutput && flatBranches) {
+    cout << "--flatBranches is ignored for the RNTuple output" << endl;
+    flatBranches=false;
   }
   
   bool isSingleMuPD( !isMC && inURL.Contains("SkimMuons"));
@@ -265,28 +261,9 @@ int main(int argc, char* argv[])
   bool isMuSkimedMCPD( isMC && inURL.Contains("HINPbPbAutumn18DR_skims") && inURL.Contains("Muons"));
   bool isEleSkimedMCPD( isMC && inURL.Contains("HINPbPbAutumn18DR_skims") && inURL.Contains("Electrons"));
   LumiRun lumiTool;
-  ElectronEfficiencyWrapper eleEff("${CMSSW_BASE}/src/HeavyIonsAnalysis/topskim/data", false);
-
-  //read expected trigger efficiencies
-  TString trigEffURL("${CMSSW_BASE}/src/HeavyIonsAnalysis/topskim/data/trigeff_mc.root");
-  gSystem->ExpandPathName(trigEffURL);
-  TFile *fIn=TFile::Open(trigEffURL);
-  TGraphAsymmErrors *e_mctrigeff=(TGraphAsymmErrors *)fIn->Get("e_pt_trigeff");
-  //TGraphAsymmErrors *m_mctrigeff=(TGraphAsymmErrors *)fIn->Get("m_eta_trigeff");
-  fIn->Close();
-
-  //read isolation efficiencies
-  TString isosfURL("${CMSSW_BASE}/src/HeavyIonsAnalysis/topskim/data/isolation_sf.root");
-  gSystem->ExpandPathName(isosfURL);
-  fIn=TFile::Open(isosfURL);
-  std::map<TString, TH2 *> isoEffSFs;
-  TString isomaps[]={"cen_169","periph_169","cen_121","periph_121"};
-  for(size_t i=0; i<sizeof(isomaps)/sizeof(TString); i++){
-    TString key(isomaps[i]);
-    isoEffSFs[key]=(TH2*)fIn->Get("sfiso2eff_"+key);
-    isoEffSFs[key]->SetDirectory(0);
-  }
-  fIn->Close();
+
+  //lepton scale factors and expected trigger efficiencies
+  ScaleFactorService sfService("${CMSSW_BASE}/src/HeavyIonsAnalysis/topskim/data", barrelEndcapEta[0]);
   
   // initialize the JEC and associated unc files
   std::vector<std::string> FilesData;
@@ -299,8 +276,8 @@ int main(int argc, char* argv[])
   
   JetCorrector JECData(FilesData);
   TString JEUDataURL("${CMSSW_BASE}/src/HeavyIonsAnalysis/topskim/data/Autumn18_HI_V6_DATA_Uncertainty_AK4PF.txt");
-  gSystem->ExpandPathName(DATA_L2RelativeURL);
-  JetUncertainty JEUData(DATA_L2RelativeURL.Data());
+  gSystem->ExpandPathName(JEUDataURL);
+  JetUncertainty JEUData(JEUDataURL.Data());
   
   std::vector<std::string> FilesMC;
   TString FilesMCURL("${CMSSW_BASE}/src/HeavyIonsAnalysis/topskim/data/Autumn18_HI_V6_MC_L2Relative_AK4PF.txt");
@@ -312,6 +289,20 @@ int main(int argc, char* argv[])
   TString JECMCURL("${CMSSW_BASE}/src/HeavyIonsAnalysis/topskim/data/Autumn18_HI_V6_MC_Uncertainty_AK4PF.txt");
   gSystem->ExpandPathName(JECMCURL);
   JetUncertainty JEUMC(JECMCURL.Data());
+
+  //split JEC uncertainty sources (MC only), all evaluated in one lookup per jet
+  JetUncertaintySources JEUSources;
+  if(isMC && jecSourcesURL!="") {
+    gSystem->ExpandPathName(jecSourcesURL);
+    JEUSources.initialize(jecSourcesURL.Data());
+  }
+
+  //optional fast path: tabulated JEC chains (refused if the interpolation error exceeds the tolerance)
+  JetCorrectorTable JECDataTable(JECData), JECMCTable(JECMC);
+  if(jecTableTol>0) {
+    if(isMC) JECMCTable.build(jecTableTol);
+    else     JECDataTable.build(jecTableTol);
+  }
   
   
   if(isPP)
@@ -343,8 +334,25 @@ int main(int argc, char* argv[])
     cout << "Will store " <<  meIdxList.size() << " ME weights" << endl;
   }
 
-  //for breit-wigner reweithing
-  TF1 *rbwigner( isMC ? getRBW(172.5,1.31) : NULL );
+  //Hessian sets, by position in meIdxList (the first 7 are the nominal and the QCD scale weights)
+  MEWeightCompressor meCompressor;
+  meCompressor.setReduceHessian(reduceHessian);
+  if(isMC) {
+    if(isPP) {
+      meCompressor.addHessianSet("nnpdf31",7,8,100,false);
+    }else{
+      meCompressor.addHessianSet("epps16",0,7,96,true);
+      meCompressor.addHessianSet("ncteq15",103,104,32,true);
+    }
+    if(meCompressor.reduceHessian())
+      cout << "Hessian sets reduced to " << meCompressor.labels(meIdxList.size()).size() << " ME weights" << endl;
+  }
+
+  //for breit-wigner reweighting: nominal (m,Gamma) of the samples and the up/down variations
+  const float topMassNom(172.5), topWidthNom(1.31);
+  const float topMassUp(173.5),  topWidthUp(1.34);
+  const float topMassDn(171.5),  topWidthDn(1.28);
+  TopMassReweighter topMassRwgt(topMassNom,topWidthNom,{ {topMassUp,topWidthUp}, {topMassDn,topWidthDn} });
 
   //book some histograms
   HistTool ht;
@@ -435,6 +443,41 @@ int main(int argc, char* argv[])
   }
   ht.addHist("jptvsjptquench",  new TH2F("jptvsjptquench", ";Reconstructed jet p_{T} [GeV];Quenched jet p_{T} [GeV];Jets",50,0,100,50,0,100) );
 
+  //handles of the histograms filled for each selected event
+  int h_lpt[2],h_leta[2],h_lchiso[2],h_lphoiso[2],h_lnhiso[2];
+  for(int i=0; i<2; i++) {
+    TString pf(Form("l%d",i+1));
+    h_lpt[i]     = ht.getHandle(pf+"pt");
+    h_leta[i]    = ht.getHandle(pf+"eta");
+    h_lchiso[i]  = ht.getHandle(pf+"chiso");
+    h_lphoiso[i] = ht.getHandle(pf+"phoiso");
+    h_lnhiso[i]  = ht.getHandle(pf+"nhiso");
+  }
+  int h_acopl(ht.getHandle("acopl")), h_detall(ht.getHandle("detall")), h_drll(ht.getHandle("drll"));
+  int h_mll(ht.getHandle("mll")), h_ptll(ht.getHandle("ptll")), h_ptsum(ht.getHandle("ptsum"));
+  int h_npfjets(ht.getHandle("npfjets")), h_npfbjets(ht.getHandle("npfbjets"));
+  int h_jbalance[2],h_jpt[2],h_jeta[2],h_jsvtxm[2],h_jsvtxntk[2],h_jcsv[2],h_jetavsphi[2];
+  for(int j=0; j<2; j++) {
+    TString ppf(j==0 ? "1" : "2");
+    h_jbalance[j]  = ht.getHandle("pf"+ppf+"jbalance");
+    h_jpt[j]       = ht.getHandle("pf"+ppf+"jpt");
+    h_jeta[j]      = ht.getHandle("pf"+ppf+"jeta");
+    h_jsvtxm[j]    = ht.getHandle("pf"+ppf+"jsvtxm");
+    h_jsvtxntk[j]  = ht.getHandle("pf"+ppf+"jsvtxntk");
+    h_jcsv[j]      = ht.getHandle("pf"+ppf+"jcsv");
+    h_jetavsphi[j] = ht.getHandle("pf"+ppf+"jetavsphi");
+  }
+  int h_jptvsjptquench(ht.getHandle("jptvsjptquench"));
+  int h_pfrapavg(ht.getHandle("pfrapavg")), h_pfraprms(ht.getHandle("pfraprms")), h_pfrapmaxspan(ht.getHandle("pfrapmaxspan"));
+  int h_pfht(ht.getHandle("pfht")), h_pfmht(ht.getHandle("pfmht"));
+  int h_fidcounter(ht.getHandle("fidcounter"));
+  HistTool::CategoryMask genCatMask(ht.categoryMask("gen"));
+
+  //the large 2D maps are filled in a small fraction of their cells and can be restricted to the flavour categories
+  if(sparseThreshold>0) ht.setSparseThreshold(sparseThreshold);
+  if(flavourJetMaps)
+    for(int j=0; j<2; j++) ht.setCategoryAllowList(Form("pf%djetavsphi",j+1),{"mm","em","ee"});
+
   // Initialize the btagging SF stuff
   BTagSFUtil * myBTagUtil = new BTagSFUtil(42);
   TRandom3 * rand = new TRandom3(2);
@@ -448,6 +491,7 @@ int main(int argc, char* argv[])
   branch->SetAddress((void*)read);
   hiInfoTree_p->GetEntry(0);
   string GT(read, 0, 100);
+  int gtEra(getGTEra(GT));
 
   //Get global event filters 
   TChain *globalTree_p     = new TChain("skimanalysis/HltTree");
@@ -540,13 +584,30 @@ int main(int argc, char* argv[])
   // =============================================================
   // marc here make the output tree
 
+  //the output file is opened first so that the tree is flushed to it in clusters during the loop
+  //(for the RNTuple output, to a temporary file from which it is imported at the end)
+  TFile *fOut = outURL!="" ? TFile::Open(outURL,"RECREATE") : nullptr;
+  TString treeURL(outURL);
+  treeURL.ReplaceAll(".root","_ttree.root");
+  if(treeURL==outURL) treeURL+="_ttree.root";
+  TFile *fTree = fOut && rntupleOutput ? TFile::Open(treeURL,"RECREATE") : nullptr;
+  OutputPolicy outPolicy(outPolicyName.Data());
   TTree * outTree = new TTree("tree", "tree with 2lepton selection and combined collections");
 
+  //per-object branches: std::vectors or, with --flatBranches, C arrays sized by nlep/nbjet/nmeWeights
+  const size_t maxLeptons(20), maxJets(100), maxMEWeights(meIdxList.size()+4);
+  auto bookArray=[&](auto &arr, const TString &name, const TString &counter, size_t maxSize) {
+    if(flatBranches) arr.book(outTree,name,counter,maxSize);
+    else             arr.book(outTree,name);
+  };
+
   // event and trigger variables
   Int_t  t_run, t_lumi, t_etrig, t_mtrig, t_isData;
   Long_t t_event;
   Float_t t_vx, t_vy, t_vz, t_weight, t_weight_BRW(1.0), t_cenbin, t_ncollWgt, t_trigSF, t_trigSFUnc;
-  std::vector<Float_t> t_meWeights;
+  Int_t t_nmeWeights(0);
+  OutputArray<Float_t> t_meWeights;
+  OutputArray<Short_t> t_meWeightsPacked;   //ratio = 1 + value/8192, see MEWeightCompressor
   outTree->Branch("run"   , &t_run  , "run/I");
   outTree->Branch("lumi"  , &t_lumi , "lumi/I");
   outTree->Branch("event" , &t_event, "event/L");
@@ -558,7 +619,9 @@ int main(int argc, char* argv[])
 
   outTree->Branch("weightBRW", &t_weight_BRW, "weightBRW/F");
   outTree->Branch("weight", &t_weight, "weight/F");
-  outTree->Branch("meWeights", &t_meWeights);
+  if(flatBranches)  outTree->Branch("nmeWeights", &t_nmeWeights, "nmeWeights/I");
+  if(packMEWeights) bookArray(t_meWeightsPacked, "meWeightsPacked", "nmeWeights", maxMEWeights);
+  else              bookArray(t_meWeights,       "meWeights",       "nmeWeights", maxMEWeights);
 
 
   // centrality and different flavors of rho
@@ -579,39 +642,39 @@ int main(int argc, char* argv[])
 
   // variables per lepton, including iso
   Int_t t_nlep, t_lep_ind1, t_lep_ind2;
-  std::vector<Float_t> t_lep_pt, t_lep_calpt, t_lep_eta, t_lep_phi, t_lep_d0, t_lep_dz, t_lep_d0err, t_lep_phiso, t_lep_chiso, t_lep_nhiso, t_lep_rho, t_lep_isofull, t_lep_miniiso,t_lep_isofull20,t_lep_isofull25,t_lep_isofull30;
-  std::vector<Bool_t> t_lep_matched,t_lep_taufeeddown,t_lep_trigmatch;
-  std::vector<Int_t  > t_lep_pdgId, t_lep_charge,t_lep_idflags;
-  std::vector<Float_t> t_lepSF,t_lepSFUnc,t_lepIsoSF,t_lepIsoSFUnc;
+  OutputArray<Float_t> t_lep_pt, t_lep_calpt, t_lep_eta, t_lep_phi, t_lep_d0, t_lep_dz, t_lep_d0err, t_lep_phiso, t_lep_chiso, t_lep_nhiso, t_lep_rho, t_lep_isofull, t_lep_miniiso,t_lep_isofull20,t_lep_isofull25,t_lep_isofull30;
+  OutputArray<Bool_t> t_lep_matched,t_lep_taufeeddown,t_lep_trigmatch;
+  OutputArray<Int_t  > t_lep_pdgId, t_lep_charge,t_lep_idflags;
+  OutputArray<Float_t> t_lepSF,t_lepSFUnc,t_lepIsoSF,t_lepIsoSFUnc;
   outTree->Branch("nlep"       , &t_nlep      , "nlep/I"            );
   outTree->Branch("lep_ind1"   , &t_lep_ind1  , "lep_ind1/I");
   outTree->Branch("lep_ind2"   , &t_lep_ind2  , "lep_ind2/I");
-  outTree->Branch("lep_pt"     , &t_lep_pt);
-  outTree->Branch("lep_calpt"     , &t_lep_calpt);
-  outTree->Branch("lep_eta"    , &t_lep_eta);
-  outTree->Branch("lep_phi"    , &t_lep_phi);
-  outTree->Branch("lep_idflags", &t_lep_idflags);
-  outTree->Branch("lep_d0"    , &t_lep_d0);
-  outTree->Branch("lep_d0err"  , &t_lep_d0err);
-  outTree->Branch("lep_dz"     , &t_lep_dz);
-  outTree->Branch("lep_phiso"  , &t_lep_phiso);
-  outTree->Branch("lep_chiso"  , &t_lep_chiso);
-  outTree->Branch("lep_nhiso"  , &t_lep_nhiso);
-  outTree->Branch("lep_rho"    , &t_lep_rho);
-  outTree->Branch("lep_pdgId"  , &t_lep_pdgId);
-  outTree->Branch("lep_charge" , &t_lep_charge);
-  outTree->Branch("lep_isofull", &t_lep_isofull);
-  outTree->Branch("lep_isofull20", &t_lep_isofull20);
-  outTree->Branch("lep_isofull25", &t_lep_isofull25);
-  outTree->Branch("lep_isofull30", &t_lep_isofull30);
-  outTree->Branch("lep_miniiso", &t_lep_miniiso);
-  outTree->Branch("lep_matched", &t_lep_matched);
-  outTree->Branch("lep_taufeeddown", &t_lep_taufeeddown);
-  outTree->Branch("lep_trigmatch", &t_lep_trigmatch);
-  outTree->Branch("lepSF",      &t_lepSF);
-  outTree->Branch("lepSFUnc",      &t_lepSFUnc);
-  outTree->Branch("lepIsoSF",      &t_lepIsoSF);
-  outTree->Branch("lepIsoSFUnc",      &t_lepIsoSFUnc);
+  bookArray(t_lep_pt,           "lep_pt",          "nlep", maxLeptons);
+  bookArray(t_lep_calpt,        "lep_calpt",       "nlep", maxLeptons);
+  bookArray(t_lep_eta,          "lep_eta",         "nlep", maxLeptons);
+  bookArray(t_lep_phi,          "lep_phi",         "nlep", maxLeptons);
+  bookArray(t_lep_idflags,      "lep_idflags",     "nlep", maxLeptons);
+  bookArray(t_lep_d0,           "lep_d0",          "nlep", maxLeptons);
+  bookArray(t_lep_d0err,        "lep_d0err",       "nlep", maxLeptons);
+  bookArray(t_lep_dz,           "lep_dz",          "nlep", maxLeptons);
+  bookArray(t_lep_phiso,        "lep_phiso",       "nlep", maxLeptons);
+  bookArray(t_lep_chiso,        "lep_chiso",       "nlep", maxLeptons);
+  bookArray(t_lep_nhiso,        "lep_nhiso",       "nlep", maxLeptons);
+  bookArray(t_lep_rho,          "lep_rho",         "nlep", maxLeptons);
+  bookArray(t_lep_pdgId,        "lep_pdgId",       "nlep", maxLeptons);
+  bookArray(t_lep_charge,       "lep_charge",      "nlep", maxLeptons);
+  bookArray(t_lep_isofull,      "lep_isofull",     "nlep", maxLeptons);
+  bookArray(t_lep_isofull20,    "lep_isofull20",   "nlep", maxLeptons);
+  bookArray(t_lep_isofull25,    "lep_isofull25",   "nlep", maxLeptons);
+  bookArray(t_lep_isofull30,    "lep_isofull30",   "nlep", maxLeptons);
+  bookArray(t_lep_miniiso,      "lep_miniiso",     "nlep", maxLeptons);
+  bookArray(t_lep_matched,      "lep_matched",     "nlep", maxLeptons);
+  bookArray(t_lep_taufeeddown,  "lep_taufeeddown", "nlep", maxLeptons);
+  bookArray(t_lep_trigmatch,    "lep_trigmatch",   "nlep", maxLeptons);
+  bookArray(t_lepSF,            "lepSF",           "nlep", maxLeptons);
+  bookArray(t_lepSFUnc,         "lepSFUnc",        "nlep", maxLeptons);
+  bookArray(t_lepIsoSF,         "lepIsoSF",        "nlep", maxLeptons);
+  bookArray(t_lepIsoSFUnc,      "lepIsoSFUnc",     "nlep", maxLeptons);
 
   // variables from dilepton system
   Float_t t_zpt(-1),t_llpt, t_llpt_raw, t_lleta, t_llphi, t_llm, t_llm_raw, t_dphi, t_deta, t_sumeta;
@@ -629,37 +692,28 @@ int main(int argc, char* argv[])
   // variables per bjet (jets ordered by csvv2)
   Int_t t_nbjet;
   Bool_t t_bjet_leadPassTight;
-  std::vector<Float_t> t_bjet_pt, t_bjet_eta, t_bjet_phi, t_bjet_mass, t_bjet_csvv2;
+  OutputArray<Float_t> t_bjet_pt, t_bjet_eta, t_bjet_phi, t_bjet_mass, t_bjet_csvv2;
   outTree->Branch("nbjet"      , &t_nbjet      , "nbjet/I"            );
   outTree->Branch("bjet_leadPassTight"    , &t_bjet_leadPassTight);
-  outTree->Branch("bjet_pt"    , &t_bjet_pt    );
-  outTree->Branch("bjet_eta"   , &t_bjet_eta   );
-  outTree->Branch("bjet_phi"   , &t_bjet_phi   );
-  outTree->Branch("bjet_mass"  , &t_bjet_mass  );
-  outTree->Branch("bjet_csvv2" , &t_bjet_csvv2 );
-
-  Int_t t_nbjet_sel, t_nbjet_sel_jecup, t_nbjet_sel_jecdn, t_nbjet_sel_jerup, t_nbjet_sel_jerdn, t_nbjet_sel_bup, t_nbjet_sel_bdn, t_nbjet_sel_udsgup, t_nbjet_sel_udsgdn, t_nbjet_sel_quenchup, t_nbjet_sel_quenchdn;
+  bookArray(t_bjet_pt,    "bjet_pt",    "nbjet", maxJets);
+  bookArray(t_bjet_eta,   "bjet_eta",   "nbjet", maxJets);
+  bookArray(t_bjet_phi,   "bjet_phi",   "nbjet", maxJets);
+  bookArray(t_bjet_mass,  "bjet_mass",  "nbjet", maxJets);
+  bookArray(t_bjet_csvv2, "bjet_csvv2", "nbjet", maxJets);
+
+  //the systematic variations of nbjet_sel are stored in friend trees, see SystematicsOutput below
+  Int_t t_nbjet_sel;
   outTree->Branch("nbjet_sel"       , &t_nbjet_sel       , "nbjet_sel/I"       );
-  outTree->Branch("nbjet_sel_jecup" , &t_nbjet_sel_jecup , "nbjet_sel_jecup/I" );
-  outTree->Branch("nbjet_sel_jecdn" , &t_nbjet_sel_jecdn , "nbjet_sel_jecdn/I" );
-  outTree->Branch("nbjet_sel_jerup" , &t_nbjet_sel_jerup , "nbjet_sel_jerup/I" );
-  outTree->Branch("nbjet_sel_jerdn" , &t_nbjet_sel_jerdn , "nbjet_sel_jerdn/I" );
-  outTree->Branch("nbjet_sel_bup"   , &t_nbjet_sel_bup   , "nbjet_sel_bup/I"   );
-  outTree->Branch("nbjet_sel_bdn"   , &t_nbjet_sel_bdn   , "nbjet_sel_bdn/I"   );
-  outTree->Branch("nbjet_sel_udsgup", &t_nbjet_sel_udsgup, "nbjet_sel_udsgup/I");
-  outTree->Branch("nbjet_sel_udsgdn", &t_nbjet_sel_udsgdn, "nbjet_sel_udsgdn/I");
-  outTree->Branch("nbjet_sel_quenchup", &t_nbjet_sel_quenchup, "nbjet_sel_quenchup/I");
-  outTree->Branch("nbjet_sel_quenchdn", &t_nbjet_sel_quenchdn, "nbjet_sel_quenchdn/I");
-
-  std::vector<Float_t> t_bjet_matchpt, t_bjet_matcheta, t_bjet_matchphi, t_bjet_matchmass;
-  outTree->Branch("bjet_genpt"    , &t_bjet_matchpt    );
-  outTree->Branch("bjet_geneta"   , &t_bjet_matcheta   );
-  outTree->Branch("bjet_genphi"   , &t_bjet_matchphi   );
-  outTree->Branch("bjet_genmass"  , &t_bjet_matchmass  );
-
-  std::vector<Int_t> t_bjet_flavor, t_bjet_flavorForB;
-  outTree->Branch("bjet_flavor"  , &t_bjet_flavor  );
-  outTree->Branch("bjet_flavorB"  , &t_bjet_flavorForB  );
+
+  OutputArray<Float_t> t_bjet_matchpt, t_bjet_matcheta, t_bjet_matchphi, t_bjet_matchmass;
+  bookArray(t_bjet_matchpt,   "bjet_genpt",   "nbjet", maxJets);
+  bookArray(t_bjet_matcheta,  "bjet_geneta",  "nbjet", maxJets);
+  bookArray(t_bjet_matchphi,  "bjet_genphi",  "nbjet", maxJets);
+  bookArray(t_bjet_matchmass, "bjet_genmass", "nbjet", maxJets);
+
+  OutputArray<Int_t> t_bjet_flavor, t_bjet_flavorForB;
+  bookArray(t_bjet_flavor,     "bjet_flavor",  "nbjet", maxJets);
+  bookArray(t_bjet_flavorForB, "bjet_flavorB", "nbjet", maxJets);
 
   // constructed variables like ht and stuff
   Float_t t_ht, t_mht, t_apt, t_dphilll2;
@@ -715,7 +769,7 @@ int main(int argc, char* argv[])
 
     
   Double_t wgtSum(0);
-  std::vector<Double_t> allWgtSum;
+  std::vector<Double_t> allWgtSum, storedWgtSum;
   int nEntries = (int)lepTree_p->GetEntries();  
   int entryDiv = ((int)(nEntries/20));    
   cout << inURL << " has " << nEntries << " events to process" << endl;
@@ -724,1000 +778,1042 @@ int main(int argc, char* argv[])
     cout << "Number of events to process limited to " << nEntries << endl;
   }
 
+  //compression and baskets of the output tree, the events to process bound the number of entries
+  const float outMultiplicity[OutputPolicy::NCLASSES]={1.,3.,10.,float(maxMEWeights)};
+  outPolicy.apply(outTree,nEntries,outMultiplicity);
+  cout << "Output tree written with the " << outPolicy.name() << " policy" << endl;
+
   //get ncoll weighting norm factor
   double ncollWgtNorm(1.0);
   if(isMC && !isPP){
     double ncollSum(0.);
     for(int entry = 0; entry < nEntries; entry++){
       hiTree_p->GetEntry(entry);
-      ncollSum+=findNcoll(fForestTree.hiBin);
+      ncollSum+=CentralityTable::glauberNcoll(fForestTree.hiBin);
     }
     if(ncollSum>0) ncollWgtNorm=double(nEntries)/ncollSum;
   }
 
-  //loop over events
-  for(int entry = 0; entry < nEntries; entry++){
+  //centrality-dependent corrections for each hiBin
+  CentralityTable cenTable(isMC,isPP,ncollWgtNorm,centralityModel,csvWP);
+
+  //loop over events (the body is instantiated for each mode, see runEventLoop)
+  JetCalibrationCache jetCalib;
+
+  //jet systematics: the number of b-tagged jets of each variation, in friend trees enabled with --syst
+  SystematicsOutput systOutput(systList);
+  static const char *jetVariationNames[JetCalibrationCache::NVARIATIONS] =
+    {"nominal","jecup","jecdn","jerup","jerdn","bup","bdn","udsgup","udsgdn","quenchup","quenchdn"};
+  for(int v=JetCalibrationCache::JECUP; v<JetCalibrationCache::NVARIATIONS; v++) {
+    SystVariation *var=systOutput.addVariation(jetVariationNames[v]);
+    if(!var) continue;
+    Int_t &nbjet=var->addInt("nbjet_sel");
+    JetCalibrationCache::Variation jetVar((JetCalibrationCache::Variation)v);
+    var->setCompute([&nbjet,&jetCalib,jetVar]{ nbjet=jetCalib.countBJets(jetVar,30.); });
+  }
+
+  //one up/down counter per JEC uncertainty source, all computed together if any of them is enabled
+  std::vector<Int_t> nbjetJECSources(2*JEUSources.size(),0);
+  bool hasJECSourceSyst(false);
+  for(size_t isrc=0; isrc<JEUSources.size(); isrc++) {
+    for(size_t k=0; k<2; k++) {
+      SystVariation *var=systOutput.addVariation("jec"+TString(JEUSources.names()[isrc])+(k==0 ? "up" : "dn"));
+      if(!var) continue;
+      hasJECSourceSyst=true;
+      Int_t &nbjet=var->addInt("nbjet_sel");
+      size_t idx(2*isrc+k);
+      var->setCompute([&nbjet,&nbjetJECSources,idx]{ nbjet=nbjetJECSources[idx]; });
+    }
+  }
+  systOutput.book(outTree->GetDirectory());
+  for(auto &var : systOutput.variations()) outPolicy.apply(var->tree(),nEntries,outMultiplicity);
+  bool fillOutput(true);
+  auto eventLoop = [&](auto mode) {
+
+    //the flags of the mode shadow the job ones in the loop: compile-time constants in the specialised modes,
+    //where the branches on them are discarded with if constexpr, tested at run time in RuntimeLoopMode
+    typedef decltype(mode) Mode;
+    const bool isMC(Mode::isMC), isPP(Mode::isPP);
+    const int gtEra(Mode::era);
+
+    for(int entry = 0; entry < nEntries; entry++){
     
-    if(entryDiv!=0)if(entry%entryDiv == 0) std::cout << "Entry # " << entry << "/" << nEntries << std::endl;
-    globalTree_p->GetEntry(entry);
-    lepTree_p->GetEntry(entry);
-    pfCandTree_p->GetEntry(entry);
-    jetTree_p->GetEntry(entry);    
-    hltTree_p->GetEntry(entry);
-    hiTree_p->GetEntry(entry);
-    // if(rhoTree_p) rhoTree_p->GetEntry(entry);
-    if(muHLTObj_p ) muHLTObj_p->GetEntry(entry);
-    if(eleHLTObj_p)  eleHLTObj_p->GetEntry(entry);
+      if(entryDiv!=0)if(entry%entryDiv == 0) std::cout << "Entry # " << entry << "/" << nEntries << std::endl;
+      globalTree_p->GetEntry(entry);
+      lepTree_p->GetEntry(entry);
+      pfCandTree_p->GetEntry(entry);
+      jetTree_p->GetEntry(entry);    
+      hltTree_p->GetEntry(entry);
+      hiTree_p->GetEntry(entry);
+      // if(rhoTree_p) rhoTree_p->GetEntry(entry);
+      if(muHLTObj_p ) muHLTObj_p->GetEntry(entry);
+      if(eleHLTObj_p)  eleHLTObj_p->GetEntry(entry);
+      quenchingModel.setEvent(fForestTree.run,fForestTree.lumi,fForestTree.evt);
     
-    //gen level analysis
-    float evWgt(1.0),topPtWgt(1.0),topMassUpWgt(1.0),topMassDnWgt(1.0);
-    int genDileptonCat(1.);
-    std::vector<TLorentzVector> genLeptons, genZLeptons, genBjets;
-    std::vector<bool> genTauLeptons;
-    std::vector<int> genLeptonIds;
-    bool isGenDilepton(false),isLeptonFiducial(false),is1bFiducial(false),is2bFiducial(false);    
-    if(isMC) {
-
-      //gen level selection
-      int nlFromTopW(0);
-      TLorentzVector topP4(0,0,0,0),antitopP4(0,0,0,0);
-      for(size_t i=0; i<fForestGen.mcPID->size(); i++) {
-        int pid=fForestGen.mcPID->at(i);
-        //int sta=fForestGen.mcStatus->at(i);
-        int mom_pid=fForestGen.mcMomPID->at(i);
-        int gmom_pid=fForestGen.mcGMomPID->at(i);
+      //gen level analysis
+      float evWgt(1.0),topPtWgt(1.0),topMassUpWgt(1.0),topMassDnWgt(1.0);
+      std::vector<double> meWgts, fidSteps;
+      std::vector<float> meRatios, meStored;
+      int genDileptonCat(1.);
+      std::vector<TLorentzVector> genLeptons, genZLeptons, genBjets;
+      std::vector<bool> genTauLeptons;
+      std::vector<int> genLeptonIds;
+      bool isGenDilepton(false),isLeptonFiducial(false),is1bFiducial(false),is2bFiducial(false);    
+      if constexpr(Mode::mayBeMC) if(isMC) {
+
+        //gen level selection
+        int nlFromTopW(0);
+        TLorentzVector topP4(0,0,0,0),antitopP4(0,0,0,0);
+        for(size_t i=0; i<fForestGen.mcPID->size(); i++) {
+          int pid=fForestGen.mcPID->at(i);
+          //int sta=fForestGen.mcStatus->at(i);
+          int mom_pid=fForestGen.mcMomPID->at(i);
+          int gmom_pid=fForestGen.mcGMomPID->at(i);
         
-        TLorentzVector p4(0,0,0,0);
-        p4.SetPtEtaPhiM( fForestGen.mcPt->at(i), fForestGen.mcEta->at(i), fForestGen.mcPhi->at(i), fForestGen.mcMass->at(i) );
+          TLorentzVector p4(0,0,0,0);
+          p4.SetPtEtaPhiM( fForestGen.mcPt->at(i), fForestGen.mcEta->at(i), fForestGen.mcPhi->at(i), fForestGen.mcMass->at(i) );
 
-        if(pid==6)  topP4=p4;
-        if(pid==-6) antitopP4=p4;
-        if( abs(pid)<6  && abs(mom_pid)==6 ) {          
-          if(p4.Pt()>30 && fabs(p4.Eta())<2.5) genBjets.push_back(p4);          
-        }
+          if(pid==6)  topP4=p4;
+          if(pid==-6) antitopP4=p4;
+          if( abs(pid)<6  && abs(mom_pid)==6 ) {          
+            if(p4.Pt()>30 && fabs(p4.Eta())<2.5) genBjets.push_back(p4);          
+          }
         
-        bool isFromTop(abs(mom_pid)==6 || abs(gmom_pid)==6 );
-        bool isFromZ( abs(mom_pid)==23 || abs(gmom_pid)==23 );
-        bool isFromW( abs(mom_pid)==24 || abs(gmom_pid)==24 );
-        bool isTauFeedDown( abs(mom_pid)==15 );
+          bool isFromTop(abs(mom_pid)==6 || abs(gmom_pid)==6 );
+          bool isFromZ( abs(mom_pid)==23 || abs(gmom_pid)==23 );
+          bool isFromW( abs(mom_pid)==24 || abs(gmom_pid)==24 );
+          bool isTauFeedDown( abs(mom_pid)==15 );
         
-        //count W leptonic decays
-        if( abs(pid)==11 || abs(pid)==13 )
-          {
-            if(isFromTop && isFromW) nlFromTopW++;
-          }
-        if(abs(pid)==16) //use tau neutrino here
-          {
-            if(isFromW && isTauFeedDown) nlFromTopW++;
-          }
-
-        //charged leptons
-        if(abs(pid)==11 || abs(pid)==13) {
-
-          //leptons from t->W->l or W->tau->l
-          if(isFromW && (isTauFeedDown || isFromTop ) ) {
-            genLeptons.push_back(p4);
-            genTauLeptons.push_back(isTauFeedDown);
-            genLeptonIds.push_back(pid);
-            genDileptonCat *= abs(pid);
+          //count W leptonic decays
+          if( abs(pid)==11 || abs(pid)==13 )
+            {
+              if(isFromTop && isFromW) nlFromTopW++;
+            }
+          if(abs(pid)==16) //use tau neutrino here
+            {
+              if(isFromW && isTauFeedDown) nlFromTopW++;
+            }
+
+          //charged leptons
+          if(abs(pid)==11 || abs(pid)==13) {
+
+            //leptons from t->W->l or W->tau->l
+            if(isFromW && (isTauFeedDown || isFromTop ) ) {
+              genLeptons.push_back(p4);
+              genTauLeptons.push_back(isTauFeedDown);
+              genLeptonIds.push_back(pid);
+              genDileptonCat *= abs(pid);
+            }
+
+            //leptons from Z->ll or Z->tt->ll
+            if(isFromZ || isTauFeedDown){
+              genZLeptons.push_back(p4);
+            }
           }
 
-          //leptons from Z->ll or Z->tt->ll
-          if(isFromZ || isTauFeedDown){
-            genZLeptons.push_back(p4);
+          //neutrinos
+          if(abs(pid)==12 || abs(pid)==14 || abs(pid)==16){
+            if(isFromZ || isTauFeedDown) {
+              genZLeptons.push_back(p4);
+            }
           }
         }
+        t_weight_BRW=getMadgraphBRWlCorrection(nlFromTopW);
+        ht.fill("br",2*nlFromTopW,1);
+        ht.fill("br",2*nlFromTopW+1,t_weight_BRW);
 
-        //neutrinos
-        if(abs(pid)==12 || abs(pid)==14 || abs(pid)==16){
-          if(isFromZ || isTauFeedDown) {
-            genZLeptons.push_back(p4);
-          }
-        }
-      }
-      t_weight_BRW=getMadgraphBRWlCorrection(nlFromTopW);
-      ht.fill("br",2*nlFromTopW,1);
-      ht.fill("br",2*nlFromTopW+1,t_weight_BRW);
-
-      TLorentzVector gendil(0,0,0,0);
-      for(auto &l:genZLeptons) gendil += l;
-      t_zpt=gendil.Pt();
+        TLorentzVector gendil(0,0,0,0);
+        for(auto &l:genZLeptons) gendil += l;
+        t_zpt=gendil.Pt();
       
-      topPtWgt = TMath::Exp(0.199-0.00166*topP4.Pt());
-      topPtWgt *= TMath::Exp(0.199-0.00166*antitopP4.Pt());
-      topPtWgt = TMath::Sqrt(topPtWgt);
-      std::vector<float> obsm={float(topP4.M()),float(antitopP4.M())};
-      topMassDnWgt = weightBW(rbwigner,obsm,171.5,1.28,172.5,1.31);
-      topMassUpWgt = weightBW(rbwigner,obsm,173.5,1.34,172.5,1.31);
+        topPtWgt = TMath::Exp(0.199-0.00166*topP4.Pt());
+        topPtWgt *= TMath::Exp(0.199-0.00166*antitopP4.Pt());
+        topPtWgt = TMath::Sqrt(topPtWgt);
+        std::vector<float> obsm={float(topP4.M()),float(antitopP4.M())};
+        const std::vector<float> &topMassWgts=topMassRwgt.weights(obsm);
+        topMassUpWgt = topMassWgts[0];
+        topMassDnWgt = topMassWgts[1];
       
-      isGenDilepton=(genLeptons.size()==2);      
-      isLeptonFiducial=(isGenDilepton && 
-                        genLeptons[0].Pt()>lepPtCut && fabs(genLeptons[0].Eta())<muEtaCut && 
-                        genLeptons[1].Pt()>lepPtCut && fabs(genLeptons[1].Eta())<muEtaCut);  
+        isGenDilepton=(genLeptons.size()==2);      
+        isLeptonFiducial=(isGenDilepton && 
+                          genLeptons[0].Pt()>lepPtCut && fabs(genLeptons[0].Eta())<muEtaCut && 
+                          genLeptons[1].Pt()>lepPtCut && fabs(genLeptons[1].Eta())<muEtaCut);  
       
-      //further cuts for electrons (EE-EB transition, HEM15/16 transition)
-      if(isLeptonFiducial){
-        for(size_t igl=0; igl<2; igl++){
-          if(abs(genLeptonIds[igl])!=11) continue;
-          float eta(genLeptons[igl].Eta());
-          float phi(genLeptons[igl].Phi());
-          if(fabs(eta) > barrelEndcapEta[0] && fabs(eta) < barrelEndcapEta[1])  {
-            isLeptonFiducial=false;
-            break;
-          }
-          if(fabs(eta)>eleEtaCut) {
-            isLeptonFiducial=false;
-            break;
+        //further cuts for electrons (EE-EB transition, HEM15/16 transition)
+        if(isLeptonFiducial){
+          for(size_t igl=0; igl<2; igl++){
+            if(abs(genLeptonIds[igl])!=11) continue;
+            float eta(genLeptons[igl].Eta());
+            float phi(genLeptons[igl].Phi());
+            if(fabs(eta) > barrelEndcapEta[0] && fabs(eta) < barrelEndcapEta[1])  {
+              isLeptonFiducial=false;
+              break;
+            }
+            if(fabs(eta)>eleEtaCut) {
+              isLeptonFiducial=false;
+              break;
+            }
+            if(eta>hem1516Eta[0] && eta<hem1516Eta[1] && phi>hem1516Phi[0] && phi<hem1516Phi[1]){
+              isLeptonFiducial=false;
+              break;
+            }          
           }
-          if(eta>hem1516Eta[0] && eta<hem1516Eta[1] && phi>hem1516Phi[0] && phi<hem1516Phi[1]){
-            isLeptonFiducial=false;
-            break;
-          }          
         }
-      }
 
-      is1bFiducial=(isLeptonFiducial && genBjets.size()>0);
-      is2bFiducial=(isLeptonFiducial && genBjets.size()>1);
+        is1bFiducial=(isLeptonFiducial && genBjets.size()>0);
+        is2bFiducial=(isLeptonFiducial && genBjets.size()>1);
       
-      //event weights and fiducial counters   
-      if(isMC) {
-        evWgt=fForestTree.ttbar_w->size()==0 ? 1. : fForestTree.ttbar_w->at(meIdxList[0]);
-        if(allWgtSum.size()==0) allWgtSum.resize(meIdxList.size(),0.);
-        for(size_t i=0; i<meIdxList.size(); i++) {
-          Double_t iwgt(fForestTree.ttbar_w->size()<i  || fForestTree.ttbar_w->size() == 0 ? 1. : fForestTree.ttbar_w->at(meIdxList[i]));
-          allWgtSum[i]+=iwgt;
-          ht.fill2D("fidcounter",0,i,iwgt,"gen");
-          if(isGenDilepton)    ht.fill2D("fidcounter",1,i,iwgt,"gen");
-          if(isLeptonFiducial) ht.fill2D("fidcounter",2,i,iwgt,"gen");
-          if(is1bFiducial)     ht.fill2D("fidcounter",3,i,iwgt,"gen");
-          if(is2bFiducial)     ht.fill2D("fidcounter",4,i,iwgt,"gen");
+        //event weights and fiducial counters   
+        if constexpr(Mode::mayBeMC) if(isMC) {
+          evWgt=fForestTree.ttbar_w->size()==0 ? 1. : fForestTree.ttbar_w->at(meIdxList[0]);
+          if(allWgtSum.size()==0) allWgtSum.resize(meIdxList.size(),0.);
+          for(size_t i=0; i<meIdxList.size(); i++) {
+            Double_t iwgt(fForestTree.ttbar_w->size()<i  || fForestTree.ttbar_w->size() == 0 ? 1. : fForestTree.ttbar_w->at(meIdxList[i]));
+            allWgtSum[i]+=iwgt;
+            meWgts.push_back(iwgt);
+          }
+
+          //exact sums of the reduced weights which are stored
+          if(meCompressor.reduceHessian()) {
+            for(auto w : meWgts) meRatios.push_back(w/meWgts[0]);
+            const std::vector<float> &stored=meCompressor.compress(meRatios);
+            if(storedWgtSum.size()==0) storedWgtSum.resize(stored.size(),0.);
+            for(size_t i=0; i<stored.size(); i++) storedWgtSum[i]+=evWgt*stored[i];
+          }
+
+          //fiducial steps passed, each filled for all the ME weights
+          fidSteps.push_back(0);
+          if(isGenDilepton)    fidSteps.push_back(1);
+          if(isLeptonFiducial) fidSteps.push_back(2);
+          if(is1bFiducial)     fidSteps.push_back(3);
+          if(is2bFiducial)     fidSteps.push_back(4);
+          ht.fillRows(h_fidcounter,genCatMask,fidSteps,meWgts);
         }
       }
-    }
         
-    wgtSum += evWgt;    
-    float plotWgt(evWgt);
+      wgtSum += evWgt;    
+      float plotWgt(evWgt);
     
-    //apply global filters
-    if(!isMC && GT.find("103X")!=string::npos){
-      if(TMath::Abs(fForestTree.vz) > 20) continue;
-      if(!fForestSkim.phfCoincFilter2Th4) continue;
-      if(!fForestSkim.pclusterCompatibilityFilter) continue;
-      if(!fForestSkim.pprimaryVertexFilter) continue;
-    }
-    else if(!isMC && GT.find("75X")!=string::npos){
-      if(TMath::Abs(fForestTree.vz) > 15) continue;
-      if(!fForestSkim.phfCoincFilter) continue;
-      if(!fForestSkim.HBHENoiseFilterResult) continue;
-      if(!fForestSkim.pcollisionEventSelection) continue;
-      if(!fForestSkim.pprimaryVertexFilter) continue;
-    }
-
-    //build jets from different PF candidate collections  
-    std::cout << "checking PF cand\t" << fForestPF.nPF << std::endl; 
-    SlimmedPFCollection_t pfColl;
-    for(int ipf=0; ipf<fForestPF.nPF; ipf++) {
-      int id(abs(fForestPF.pfId->at(ipf)));
-      float mass(0.13957);  //pions
-      if(id==4) mass=0.;    //photons
-      if(id>=5) mass=0.497; //K0L
-      pfColl.push_back( getSlimmedPF( id, fForestPF.pfPt->at(ipf),fForestPF.pfEta->at(ipf),fForestPF.pfPhi->at(ipf),mass) );
-    }
+      //apply global filters
+      if constexpr(Mode::mayBeData && Mode::mayBeEra(ERA_103X)) if(!isMC && gtEra==ERA_103X) {
+        if(TMath::Abs(fForestTree.vz) > 20) continue;
+        if(!fForestSkim.phfCoincFilter2Th4) continue;
+        if(!fForestSkim.pclusterCompatibilityFilter) continue;
+        if(!fForestSkim.pprimaryVertexFilter) continue;
+      }
+      if constexpr(Mode::mayBeData && (Mode::mayBeEra(ERA_75X) || Mode::mayBeEra(ERA_75X_MCRUN2))) if(!isMC && (gtEra==ERA_75X || gtEra==ERA_75X_MCRUN2)) {
+        if(TMath::Abs(fForestTree.vz) > 15) continue;
+        if(!fForestSkim.phfCoincFilter) continue;
+        if(!fForestSkim.HBHENoiseFilterResult) continue;
+        if(!fForestSkim.pcollisionEventSelection) continue;
+        if(!fForestSkim.pprimaryVertexFilter) continue;
+      }
 
-    Float_t globalrho = getRho(pfColl,{1,2,3,4,5,6},-1.,5.);
+      //build jets from different PF candidate collections  
+      std::cout << "checking PF cand\t" << fForestPF.nPF << std::endl; 
+      SlimmedPFCollection_t pfColl;
+      for(int ipf=0; ipf<fForestPF.nPF; ipf++) {
+        int id(abs(fForestPF.pfId->at(ipf)));
+        float mass(0.13957);  //pions
+        if(id==4) mass=0.;    //photons
+        if(id>=5) mass=0.497; //K0L
+        pfColl.push_back( getSlimmedPF( id, fForestPF.pfPt->at(ipf),fForestPF.pfEta->at(ipf),fForestPF.pfPhi->at(ipf),mass) );
+      }
 
-    //monitor trigger and centrality
-    float cenBin(0.),ncoll(1.);
-    bool isCentralEvent(false);
-    if(!isPP){
-      isCentralEvent=(fForestTree.hiBin<30);
-      cenBin=0.5*fForestTree.hiBin;
-      ncoll=findNcoll(fForestTree.hiBin)*ncollWgtNorm;
-    }
-    if(!isMC){
-      Int_t runBin=lumiTool.getRunBin(fForestTree.run);
-      Float_t lumi=lumiTool.getLumi(fForestTree.run);
-      if(lumi>0.){
-        if(etrig>0) ht.fill("ratevsrun",runBin,1./lumi,"e");
-        if(mtrig>0) ht.fill("ratevsrun",runBin,1./lumi,"m");
+      Float_t globalrho = getRho(pfColl,{1,2,3,4,5,6},-1.,5.);
+
+      //monitor trigger and centrality
+      const CentralityContext &cenCtx=cenTable.get(fForestTree.hiBin);
+      float cenBin(cenCtx.cenBin),ncoll(cenCtx.ncoll);
+      bool isCentralEvent(cenCtx.isCentral);
+      if constexpr(Mode::mayBeData) if(!isMC) {
+        Int_t runBin=lumiTool.getRunBin(fForestTree.run);
+        Float_t lumi=lumiTool.getLumi(fForestTree.run);
+        if(lumi>0.){
+          if(etrig>0) ht.fill("ratevsrun",runBin,1./lumi,"e");
+          if(mtrig>0) ht.fill("ratevsrun",runBin,1./lumi,"m");
+        }
       }
-    }
 
-    //the selected leptons
-    std::vector<LeptonSummary> selLeptons;
+      //the selected leptons
+      std::vector<LeptonSummary> selLeptons;
     
-    //select muons
-    std::vector<LeptonSummary> noIdMu;
-    std::vector<TLorentzVector> muHLTP4;
-    if(muHLTObjs) muHLTP4=muHLTObjs->getHLTObjectsP4();
-    cout << __LINE__ << endl;
-    for(unsigned int muIter = 0; muIter < fForestLep.muPt->size(); ++muIter) {
-    cout << __LINE__ << endl;
-      //kinematics selection
-      TLorentzVector p4(0,0,0,0);
-      float rawpt(fForestLep.muPt->at(muIter));
-      p4.SetPtEtaPhiM(rawpt,fForestLep.muEta->at(muIter),fForestLep.muPhi->at(muIter),0.1057);
-
-      //no specific calibration for muons:this is just left for symmetry with what is done for electrons
-      float calpt=p4.Pt(); 
-      p4 *= calpt/rawpt;  
-
-      if(TMath::Abs(p4.Eta()) > muEtaCut) continue;
-      if(p4.Pt() < lepPtCut) continue;
-
-      bool isTrigMatch(false);
-      for(auto hp4: muHLTP4) {
-        if(hp4.DeltaR(p4)>0.1) continue;
-        isTrigMatch=true;
-        break;
-      }
+      //select muons
+      std::vector<LeptonSummary> noIdMu;
+      std::vector<TLorentzVector> muHLTP4;
+      if(muHLTObjs) muHLTP4=muHLTObjs->getHLTObjectsP4();
+      cout << __LINE__ << endl;
+      for(unsigned int muIter = 0; muIter < fForestLep.muPt->size(); ++muIter) {
+      cout << __LINE__ << endl;
+        //kinematics selection
+        TLorentzVector p4(0,0,0,0);
+        float rawpt(fForestLep.muPt->at(muIter));
+        p4.SetPtEtaPhiM(rawpt,fForestLep.muEta->at(muIter),fForestLep.muPhi->at(muIter),0.1057);
+
+        //no specific calibration for muons:this is just left for symmetry with what is done for electrons
+        float calpt=p4.Pt(); 
+        p4 *= calpt/rawpt;  
+
+        if(TMath::Abs(p4.Eta()) > muEtaCut) continue;
+        if(p4.Pt() < lepPtCut) continue;
+
+        bool isTrigMatch(false);
+        for(auto hp4: muHLTP4) {
+          if(hp4.DeltaR(p4)>0.1) continue;
+          isTrigMatch=true;
+          break;
+        }
       
-      LeptonSummary l(13,p4);
-      l.rawpt = p4.Pt()*(rawpt/calpt); // calpt == pt for muons
-      l.isTrigMatch=isTrigMatch;
-      l.charge  = fForestLep.muCharge->at(muIter);
-      l.chiso   = fForestLep.muPFChIso->at(muIter);
-      l.nhiso   = fForestLep.muPFNeuIso->at(muIter);
-      l.phoiso  = fForestLep.muPFPhoIso->at(muIter);
-      l.isofull = l.chiso+l.nhiso+l.phoiso;
-      // int   tmp_rhoind  = getRhoIndex(p4.Eta(),t_etaMin,t_etaMax);
-      // l.rho = isPP ? globalrho : t_rho->at(tmp_rhoind);
+        LeptonSummary l(13,p4);
+        l.rawpt = p4.Pt()*(rawpt/calpt); // calpt == pt for muons
+        l.isTrigMatch=isTrigMatch;
+        l.charge  = fForestLep.muCharge->at(muIter);
+        l.chiso   = fForestLep.muPFChIso->at(muIter);
+        l.nhiso   = fForestLep.muPFNeuIso->at(muIter);
+        l.phoiso  = fForestLep.muPFPhoIso->at(muIter);
+        l.isofull = l.chiso+l.nhiso+l.phoiso;
+        // int   tmp_rhoind  = getRhoIndex(p4.Eta(),t_etaMin,t_etaMax);
+        // l.rho = isPP ? globalrho : t_rho->at(tmp_rhoind);
       
-      l.isofullR=getIsolationFull( pfColl, l.p4);
-      l.miniiso = getMiniIsolation( pfColl ,l.p4, l.id);
-      l.d0      = fForestLep.muD0   ->at(muIter);
-      l.d0err   = 0.; //fForestLep.muD0Err->at(muIter); // no d0err for muons!!!
-      l.dz      = fForestLep.muDz   ->at(muIter);
-      l.origIdx = muIter;
-      l.isMatched=false;
-      l.isTauFeedDown=false;
-      for(size_t ig=0;ig<genLeptons.size(); ig++) {
-        if(genLeptons[ig].DeltaR(l.p4)<0.1) continue;
-        l.isMatched=true;
-        l.isTauFeedDown=genTauLeptons[ig];
-      }
+        l.isofullR=getIsolationFull( pfColl, l.p4);
+        l.miniiso = getMiniIsolation( pfColl ,l.p4, l.id);
+        l.d0      = fForestLep.muD0   ->at(muIter);
+        l.d0err   = 0.; //fForestLep.muD0Err->at(muIter); // no d0err for muons!!!
+        l.dz      = fForestLep.muDz   ->at(muIter);
+        l.origIdx = muIter;
+        l.isMatched=false;
+        l.isTauFeedDown=false;
+        for(size_t ig=0;ig<genLeptons.size(); ig++) {
+          if(genLeptons[ig].DeltaR(l.p4)<0.1) continue;
+          l.isMatched=true;
+          l.isTauFeedDown=genTauLeptons[ig];
+        }
     
-      noIdMu.push_back(l);
-
-      //id (Tight muon requirements)
-      int type=fForestLep.muType->at(muIter);
-      bool isGlobal( ((type>>1)&0x1) );
-      if(!isGlobal) continue;
-      bool isPF( ((type>>5)&0x1) );
-      if(!isPF) continue;
-      bool isGlobalMuonPromptTight(fForestLep.muChi2NDF->at(muIter)<10. && fForestLep.muMuonHits->at(muIter)>0);
-      if(!isGlobalMuonPromptTight) continue;
-      if(fForestLep.muStations->at(muIter)<=1) continue;
-      if(fForestLep.muTrkLayers->at(muIter) <= 5) continue;
-      if(fForestLep.muPixelHits->at(muIter) == 0) continue;
-      if(TMath::Abs(fForestLep.muInnerD0->at(muIter)) >=0.2 ) continue;
-      if(TMath::Abs(fForestLep.muInnerDz->at(muIter)) >=0.5) continue;
-
-      l.idFlags=1;
-
-      //selected a good muon
-      selLeptons.push_back(l);
-    }
-    std::sort(noIdMu.begin(),noIdMu.end(),orderByPt);
+        noIdMu.push_back(l);
+
+        //id (Tight muon requirements)
+        int type=fForestLep.muType->at(muIter);
+        bool isGlobal( ((type>>1)&0x1) );
+        if(!isGlobal) continue;
+        bool isPF( ((type>>5)&0x1) );
+        if(!isPF) continue;
+        bool isGlobalMuonPromptTight(fForestLep.muChi2NDF->at(muIter)<10. && fForestLep.muMuonHits->at(muIter)>0);
+        if(!isGlobalMuonPromptTight) continue;
+        if(fForestLep.muStations->at(muIter)<=1) continue;
+        if(fForestLep.muTrkLayers->at(muIter) <= 5) continue;
+        if(fForestLep.muPixelHits->at(muIter) == 0) continue;
+        if(TMath::Abs(fForestLep.muInnerD0->at(muIter)) >=0.2 ) continue;
+        if(TMath::Abs(fForestLep.muInnerDz->at(muIter)) >=0.5) continue;
+
+        l.idFlags=1;
+
+        //selected a good muon
+        selLeptons.push_back(l);
+      }
+      std::sort(noIdMu.begin(),noIdMu.end(),orderByPt);
         
-    //monitor muon id variables
-    if(noIdMu.size()>1) {
-      TLorentzVector p4[2] = {noIdMu[0].p4,      noIdMu[1].p4};
-      int midx[2]          = {noIdMu[0].origIdx, noIdMu[1].origIdx};
-      int charge(noIdMu[0].charge*noIdMu[1].charge);
+      //monitor muon id variables
+      if(noIdMu.size()>1) {
+        TLorentzVector p4[2] = {noIdMu[0].p4,      noIdMu[1].p4};
+        int midx[2]          = {noIdMu[0].origIdx, noIdMu[1].origIdx};
+        int charge(noIdMu[0].charge*noIdMu[1].charge);
  
-      TString cat("zmmctrl");
-      if(charge>0) cat="ss"+cat;
-      float mmm((p4[0]+p4[1]).M());
-      if(mmm<20) continue;
-
-      ht.fill("mmll",  mmm,         plotWgt,cat);
-      if( fabs(mmm-91)<15 && isSingleMuPD && mtrig>0 ) {
-        for(size_t i=0; i<2; i++) {
-          ht.fill("mmusta",    fForestLep.muStations->at(midx[i]),            plotWgt,cat);
-          ht.fill("mtrklay",   fForestLep.muTrkLayers->at(midx[i]),           plotWgt,cat);
-          ht.fill("mchi2ndf",  fForestLep.muChi2NDF->at(midx[i]),             plotWgt,cat);
-          ht.fill("mmuhits",   fForestLep.muMuonHits->at(midx[i]),            plotWgt,cat);
-          ht.fill("mpxhits",   fForestLep.muPixelHits->at(midx[i]),           plotWgt,cat);
-          ht.fill("md0",       TMath::Abs(fForestLep.muInnerD0->at(midx[i])), plotWgt,cat);
-          ht.fill("mdz",       TMath::Abs(fForestLep.muInnerDz->at(midx[i])), plotWgt,cat);          
+        TString cat("zmmctrl");
+        if(charge>0) cat="ss"+cat;
+        float mmm((p4[0]+p4[1]).M());
+        if(mmm<20) continue;
+
+        ht.fill("mmll",  mmm,         plotWgt,cat);
+        if( fabs(mmm-91)<15 && isSingleMuPD && mtrig>0 ) {
+          for(size_t i=0; i<2; i++) {
+            ht.fill("mmusta",    fForestLep.muStations->at(midx[i]),            plotWgt,cat);
+            ht.fill("mtrklay",   fForestLep.muTrkLayers->at(midx[i]),           plotWgt,cat);
+            ht.fill("mchi2ndf",  fForestLep.muChi2NDF->at(midx[i]),             plotWgt,cat);
+            ht.fill("mmuhits",   fForestLep.muMuonHits->at(midx[i]),            plotWgt,cat);
+            ht.fill("mpxhits",   fForestLep.muPixelHits->at(midx[i]),           plotWgt,cat);
+            ht.fill("md0",       TMath::Abs(fForestLep.muInnerD0->at(midx[i])), plotWgt,cat);
+            ht.fill("mdz",       TMath::Abs(fForestLep.muInnerDz->at(midx[i])), plotWgt,cat);          
+          }
         }
       }
-    }
 
 
-    //select electrons
-    //cf. https://twiki.cern.ch/twiki/pub/CMS/HiHighPt2019/HIN_electrons2018_followUp.pdf
-    std::vector<LeptonSummary> noIdEle;
-    std::vector<TLorentzVector> eleHLTP4;
-    if(eleHLTObjs) eleHLTP4=eleHLTObjs->getHLTObjectsP4() ;
-    for(unsigned int eleIter = 0; eleIter < fForestLep.elePt->size(); ++eleIter) {
-
-      //kinematics selection
-      TLorentzVector p4(0,0,0,0);
-      float rawpt(fForestLep.elePt->at(eleIter));
-      p4.SetPtEtaPhiM(rawpt,fForestLep.eleEta->at(eleIter),fForestLep.elePhi->at(eleIter),0.000511);
-
-      //deprecated
-      //apply ad-hoc shift for endcap electrons if needed, i.e., PromptReco'18
-      //if(!isMC && fForestTree.run<=firstEEScaleShiftRun && TMath::Abs(p4.Eta())>=barrelEndcapEta[1] && GT.find("fixEcalADCToGeV")==string::npos && GT.find("75X")==string::npos)
-      //  p4 *=eeScaleShift;         
-      float calpt=calibratedPt(rawpt, p4.Eta(), cenBin, isMC);
-      p4 *= calpt/rawpt;
-      if(TMath::Abs(p4.Eta()) > eleEtaCut) continue;
-      if(TMath::Abs(p4.Eta()) > barrelEndcapEta[0] && TMath::Abs(p4.Eta()) < barrelEndcapEta[1] ) continue;
-      if(p4.Pt() < lepPtCut) continue;
-      bool isTrigMatch(false);
-      for(auto hp4: eleHLTP4) {
-        if(hp4.DeltaR(p4)>0.2) continue;
-        isTrigMatch=true;
-        break;
-      }
+      //select electrons
+      //cf. https://twiki.cern.ch/twiki/pub/CMS/HiHighPt2019/HIN_electrons2018_followUp.pdf
+      std::vector<LeptonSummary> noIdEle;
+      std::vector<TLorentzVector> eleHLTP4;
+      if(eleHLTObjs) eleHLTP4=eleHLTObjs->getHLTObjectsP4() ;
+      for(unsigned int eleIter = 0; eleIter < fForestLep.elePt->size(); ++eleIter) {
 
-      LeptonSummary l(11,p4);
-      l.rawpt = p4.Pt()*(rawpt/calpt);
-      l.isTrigMatch=isTrigMatch;
-      l.charge  = fForestLep.eleCharge->at(eleIter);
-      if(GT.find("75X_mcRun2")==string::npos) {
-	l.chiso   = fForestLep.elePFChIso03->at(eleIter);
-	l.nhiso   = fForestLep.elePFNeuIso03->at(eleIter);
-	l.phoiso  = fForestLep.elePFPhoIso03->at(eleIter);
-      }else{
-        l.chiso   = fForestLep.elePFChIso->at(eleIter);
-        l.nhiso   = fForestLep.elePFNeuIso->at(eleIter);
-        l.phoiso  = fForestLep.elePFPhoIso->at(eleIter);
-      }
-      l.isofull = l.chiso+l.nhiso+l.phoiso;
-      // int   tmp_rhoind  = getRhoIndex(p4.Eta(),t_etaMin,t_etaMax);
-      // l.rho = isPP ? globalrho : t_rho->at(tmp_rhoind);
-
-      l.isofullR= getIsolationFull( pfColl, l.p4);
-      l.miniiso = getMiniIsolation( pfColl ,l.p4, l.id);
-      l.d0      = fForestLep.eleD0   ->at(eleIter);
-      l.d0err   = fForestLep.eleD0Err->at(eleIter);
-      l.dz      = fForestLep.eleDz   ->at(eleIter);
-      l.origIdx=eleIter;
-      l.isMatched=false;
-      l.isTauFeedDown=false;
-      for(size_t ig=0;ig<genLeptons.size(); ig++) {
-        if(genLeptons[ig].DeltaR(l.p4)<0.1) continue;
-        l.isMatched=true;
-        l.isTauFeedDown=genTauLeptons[ig];
-      }
+        //kinematics selection
+        TLorentzVector p4(0,0,0,0);
+        float rawpt(fForestLep.elePt->at(eleIter));
+        p4.SetPtEtaPhiM(rawpt,fForestLep.eleEta->at(eleIter),fForestLep.elePhi->at(eleIter),0.000511);
+
+        //deprecated
+        //apply ad-hoc shift for endcap electrons if needed, i.e., PromptReco'18
+        //if(!isMC && fForestTree.run<=firstEEScaleShiftRun && TMath::Abs(p4.Eta())>=barrelEndcapEta[1] && GT.find("fixEcalADCToGeV")==string::npos && GT.find("75X")==string::npos)
+        //  p4 *=eeScaleShift;         
+        float calpt=calibratedPt(rawpt, p4.Eta(), cenCtx, isMC);
+        p4 *= calpt/rawpt;
+        if(TMath::Abs(p4.Eta()) > eleEtaCut) continue;
+        if(TMath::Abs(p4.Eta()) > barrelEndcapEta[0] && TMath::Abs(p4.Eta()) < barrelEndcapEta[1] ) continue;
+        if(p4.Pt() < lepPtCut) continue;
+        bool isTrigMatch(false);
+        for(auto hp4: eleHLTP4) {
+          if(hp4.DeltaR(p4)>0.2) continue;
+          isTrigMatch=true;
+          break;
+        }
+
+        LeptonSummary l(11,p4);
+        l.rawpt = p4.Pt()*(rawpt/calpt);
+        l.isTrigMatch=isTrigMatch;
+        l.charge  = fForestLep.eleCharge->at(eleIter);
+        if constexpr(Mode::mayBeNotEra(ERA_75X_MCRUN2)) if(gtEra!=ERA_75X_MCRUN2) {
+          l.chiso   = fForestLep.elePFChIso03->at(eleIter);
+          l.nhiso   = fForestLep.elePFNeuIso03->at(eleIter);
+          l.phoiso  = fForestLep.elePFPhoIso03->at(eleIter);
+        }
+        if constexpr(Mode::mayBeEra(ERA_75X_MCRUN2)) if(gtEra==ERA_75X_MCRUN2) {
+          l.chiso   = fForestLep.elePFChIso->at(eleIter);
+          l.nhiso   = fForestLep.elePFNeuIso->at(eleIter);
+          l.phoiso  = fForestLep.elePFPhoIso->at(eleIter);
+        }
+        l.isofull = l.chiso+l.nhiso+l.phoiso;
+        // int   tmp_rhoind  = getRhoIndex(p4.Eta(),t_etaMin,t_etaMax);
+        // l.rho = isPP ? globalrho : t_rho->at(tmp_rhoind);
+
+        l.isofullR= getIsolationFull( pfColl, l.p4);
+        l.miniiso = getMiniIsolation( pfColl ,l.p4, l.id);
+        l.d0      = fForestLep.eleD0   ->at(eleIter);
+        l.d0err   = fForestLep.eleD0Err->at(eleIter);
+        l.dz      = fForestLep.eleDz   ->at(eleIter);
+        l.origIdx=eleIter;
+        l.isMatched=false;
+        l.isTauFeedDown=false;
+        for(size_t ig=0;ig<genLeptons.size(); ig++) {
+          if(genLeptons[ig].DeltaR(l.p4)<0.1) continue;
+          l.isMatched=true;
+          l.isTauFeedDown=genTauLeptons[ig];
+        }
 
-      noIdEle.push_back(l);
+        noIdEle.push_back(l);
       
-      l.idFlags=getElectronId(TMath::Abs(fForestLep.eleSCEta->at(eleIter))< barrelEndcapEta[0],
-                                 fForestLep.eleSigmaIEtaIEta->at(eleIter),
-                                 fForestLep.eledEtaSeedAtVtx->at(eleIter),
-                                 fForestLep.eledPhiAtVtx->at(eleIter),
-                                 fForestLep.eleHoverEBc->at(eleIter),
-                                 fForestLep.eleEoverPInv->at(eleIter),
-                                 fForestLep.eleIP3D->at(eleIter),
-                                 fForestLep.eleMissHits->at(eleIter),
-                                 isCentralEvent);
+        l.idFlags=getElectronId(TMath::Abs(fForestLep.eleSCEta->at(eleIter))< barrelEndcapEta[0],
+                                   fForestLep.eleSigmaIEtaIEta->at(eleIter),
+                                   fForestLep.eledEtaSeedAtVtx->at(eleIter),
+                                   fForestLep.eledPhiAtVtx->at(eleIter),
+                                   fForestLep.eleHoverEBc->at(eleIter),
+                                   fForestLep.eleEoverPInv->at(eleIter),
+                                   fForestLep.eleIP3D->at(eleIter),
+                                   fForestLep.eleMissHits->at(eleIter),
+                                   isCentralEvent);
       
-      //id'ed electron
-      if(!isLooseElectron(l.idFlags)) continue;
-      selLeptons.push_back(l);
-    }
-    std::sort(noIdEle.begin(),noIdEle.end(),orderByPt);       
-
-    //monitor electron id variables
-    if(noIdEle.size()>1) {
-      TLorentzVector p4[2] = {noIdEle[0].p4,noIdEle[1].p4};
-      int eidx[2]          = {noIdEle[0].origIdx,noIdEle[1].origIdx};
-      int charge(noIdEle[0].charge*noIdEle[1].charge);
-      float mee((p4[0]+p4[1]).M());
-      if(mee<20) continue;
+        //id'ed electron
+        if(!isLooseElectron(l.idFlags)) continue;
+        selLeptons.push_back(l);
+      }
+      std::sort(noIdEle.begin(),noIdEle.end(),orderByPt);       
+
+      //monitor electron id variables
+      if(noIdEle.size()>1) {
+        TLorentzVector p4[2] = {noIdEle[0].p4,noIdEle[1].p4};
+        int eidx[2]          = {noIdEle[0].origIdx,noIdEle[1].origIdx};
+        int charge(noIdEle[0].charge*noIdEle[1].charge);
+        float mee((p4[0]+p4[1]).M());
+        if(mee<20) continue;
       
-      TString basecat("zeectrl");
-      if(charge>0) basecat="ss"+basecat;      
-      TString cat(basecat);
-      if(fabs(noIdEle[0].p4.Eta())>=barrelEndcapEta[1] && fabs(noIdEle[1].p4.Eta())>=barrelEndcapEta[1])
-        cat +="EE";
-      else if(fabs(noIdEle[0].p4.Eta())>=barrelEndcapEta[1] || fabs(noIdEle[1].p4.Eta())>=barrelEndcapEta[1])
-        cat+="EB";
-      else
-        cat+="BB";
-      ht.fill("emll",  mee,         plotWgt,cat);
-
-      if( fabs(mee-91)<15 && isSingleElePD && etrig>0) {
-        for(size_t i=0; i<2; i++) {
-          cat=basecat;
-          cat += (fabs(p4[i].Eta())>=barrelEndcapEta[1] ? "EE" : "EB");
-          ht.fill("esihih",  fForestLep.eleSigmaIEtaIEta->at(eidx[i]),         plotWgt,cat);
-          ht.fill("edetaseedvtx", TMath::Abs(fForestLep.eledEtaSeedAtVtx->at(eidx[i])), plotWgt,cat);
-          ht.fill("edphivtx", TMath::Abs(fForestLep.eledPhiAtVtx->at(eidx[i])), plotWgt,cat);
-          ht.fill("ehoebc",     fForestLep.eleHoverEBc->at(eidx[i]),                plotWgt,cat);
-          ht.fill("eempinv",  fForestLep.eleEoverPInv->at(eidx[i]),             plotWgt,cat);
-          ht.fill("e3dip",    TMath::Abs(fForestLep.eleIP3D->at(eidx[i])),        plotWgt,cat);
+        TString basecat("zeectrl");
+        if(charge>0) basecat="ss"+basecat;      
+        TString cat(basecat);
+        if(fabs(noIdEle[0].p4.Eta())>=barrelEndcapEta[1] && fabs(noIdEle[1].p4.Eta())>=barrelEndcapEta[1])
+          cat +="EE";
+        else if(fabs(noIdEle[0].p4.Eta())>=barrelEndcapEta[1] || fabs(noIdEle[1].p4.Eta())>=barrelEndcapEta[1])
+          cat+="EB";
+        else
+          cat+="BB";
+        ht.fill("emll",  mee,         plotWgt,cat);
+
+        if( fabs(mee-91)<15 && isSingleElePD && etrig>0) {
+          for(size_t i=0; i<2; i++) {
+            cat=basecat;
+            cat += (fabs(p4[i].Eta())>=barrelEndcapEta[1] ? "EE" : "EB");
+            ht.fill("esihih",  fForestLep.eleSigmaIEtaIEta->at(eidx[i]),         plotWgt,cat);
+            ht.fill("edetaseedvtx", TMath::Abs(fForestLep.eledEtaSeedAtVtx->at(eidx[i])), plotWgt,cat);
+            ht.fill("edphivtx", TMath::Abs(fForestLep.eledPhiAtVtx->at(eidx[i])), plotWgt,cat);
+            ht.fill("ehoebc",     fForestLep.eleHoverEBc->at(eidx[i]),                plotWgt,cat);
+            ht.fill("eempinv",  fForestLep.eleEoverPInv->at(eidx[i]),             plotWgt,cat);
+            ht.fill("e3dip",    TMath::Abs(fForestLep.eleIP3D->at(eidx[i])),        plotWgt,cat);
+          }
         }
       }
-    }
 
-    //sort selected electrons by pt
-    std::sort(selLeptons.begin(),selLeptons.end(),orderByPt);
-
-    //monitor trigger efficiency
-    if(selLeptons.size()>=2){
-      for(size_t ilep=0; ilep<2; ilep++){
-        if(!selLeptons[ilep].isMatched) continue;
-        TString cat( abs(selLeptons[ilep].id)==11 ? "e" : "m");
-        float pt(selLeptons[ilep].p4.Pt()), abseta(fabs(selLeptons[ilep].p4.Eta()));
-        ht.fill("trig_pt",  pt,     ncoll, cat);          
-        ht.fill("trig_eta", abseta, ncoll, cat);          
-        if(!selLeptons[ilep].isTrigMatch) continue;
-        cat+="match";
-        ht.fill("trig_pt",  pt,     ncoll, cat);          
-        ht.fill("trig_eta", abseta, ncoll, cat);          
+      //sort selected electrons by pt
+      std::sort(selLeptons.begin(),selLeptons.end(),orderByPt);
+
+      //monitor trigger efficiency
+      if(selLeptons.size()>=2){
+        for(size_t ilep=0; ilep<2; ilep++){
+          if(!selLeptons[ilep].isMatched) continue;
+          TString cat( abs(selLeptons[ilep].id)==11 ? "e" : "m");
+          float pt(selLeptons[ilep].p4.Pt()), abseta(fabs(selLeptons[ilep].p4.Eta()));
+          ht.fill("trig_pt",  pt,     ncoll, cat);          
+          ht.fill("trig_eta", abseta, ncoll, cat);          
+          if(!selLeptons[ilep].isTrigMatch) continue;
+          cat+="match";
+          ht.fill("trig_pt",  pt,     ncoll, cat);          
+          ht.fill("trig_eta", abseta, ncoll, cat);          
+        }
       }
-    }
 
-    //require at least two leptons matched to trigger objects
-    if(selLeptons.size()<2) continue;
-    bool hasOneTrigMatchLepton(selLeptons[0].isTrigMatch || selLeptons[1].isTrigMatch);
-    if( !hasOneTrigMatchLepton ) continue;
+      //require at least two leptons matched to trigger objects
+      if(selLeptons.size()<2) continue;
+      bool hasOneTrigMatchLepton(selLeptons[0].isTrigMatch || selLeptons[1].isTrigMatch);
+      if( !hasOneTrigMatchLepton ) continue;
     
-    //apply trigger preselection & duplicate event removal
-    //in skim mode assume that the hltobject matched to offline will give the HLT trigger bit
-    //this is a hack when hlt tree is missing...
-    if(isSkim) {
-      if( (abs(selLeptons[0].id)==11 && selLeptons[0].isTrigMatch) ||
-          (abs(selLeptons[1].id)==11 && selLeptons[1].isTrigMatch) ) etrig=true;
-      if( (abs(selLeptons[0].id)==13 && selLeptons[0].isTrigMatch) ||
-          (abs(selLeptons[1].id)==13 && selLeptons[1].isTrigMatch) ) mtrig=true;
-    }
+      //apply trigger preselection & duplicate event removal
+      //in skim mode assume that the hltobject matched to offline will give the HLT trigger bit
+      //this is a hack when hlt tree is missing...
+      if(isSkim) {
+        if( (abs(selLeptons[0].id)==11 && selLeptons[0].isTrigMatch) ||
+            (abs(selLeptons[1].id)==11 && selLeptons[1].isTrigMatch) ) etrig=true;
+        if( (abs(selLeptons[0].id)==13 && selLeptons[0].isTrigMatch) ||
+            (abs(selLeptons[1].id)==13 && selLeptons[1].isTrigMatch) ) mtrig=true;
+      }
 
-    int trig=etrig+mtrig;
-    if(trig==0) continue;
+      int trig=etrig+mtrig;
+      if(trig==0) continue;
 
-    if(isSingleMuPD || isMuSkimedMCPD) {
-      if(std::find(badMuonTriggerRuns.begin(), badMuonTriggerRuns.end(), fForestTree.run) != badMuonTriggerRuns.end() and !isMuSkimedMCPD) continue;
-      if(mtrig==0) continue;
-      if(etrig!=0) continue;
-      if(selLeptons.size()>=2)
-	if ( (abs(selLeptons[0].id)==11 and selLeptons[0].isTrigMatch==1) and (abs(selLeptons[1].id)==11 and selLeptons[1].isTrigMatch==1) ) continue;
-    }
-    if(isSingleElePD || isEleSkimedMCPD) {
-      if(etrig==0) continue;
-      if(selLeptons.size()>=2)
-	if ( (abs(selLeptons[0].id)==13 and selLeptons[0].isTrigMatch==1) or (abs(selLeptons[1].id)==13 and selLeptons[1].isTrigMatch==1) ) continue;
-    }
+      if(isSingleMuPD || isMuSkimedMCPD) {
+        if(std::find(badMuonTriggerRuns.begin(), badMuonTriggerRuns.end(), fForestTree.run) != badMuonTriggerRuns.end() and !isMuSkimedMCPD) continue;
+        if(mtrig==0) continue;
+        if(etrig!=0) continue;
+        if(selLeptons.size()>=2)
+          if ( (abs(selLeptons[0].id)==11 and selLeptons[0].isTrigMatch==1) and (abs(selLeptons[1].id)==11 and selLeptons[1].isTrigMatch==1) ) continue;
+      }
+      if(isSingleElePD || isEleSkimedMCPD) {
+        if(etrig==0) continue;
+        if(selLeptons.size()>=2)
+          if ( (abs(selLeptons[0].id)==13 and selLeptons[0].isTrigMatch==1) or (abs(selLeptons[1].id)==13 and selLeptons[1].isTrigMatch==1) ) continue;
+      }
 
-    //dilepton selection
-    TLorentzVector ll(selLeptons[0].p4+selLeptons[1].p4);
-    TLorentzVector ll_raw(selLeptons[0].p4*(selLeptons[0].rawpt/selLeptons[0].p4.Pt())+selLeptons[1].p4*(selLeptons[1].rawpt/selLeptons[1].p4.Pt()));
-    t_llpt=ll.Pt();
-    t_llpt_raw=ll_raw.Pt();
-    t_lleta=ll.Eta();
-    t_llphi=ll.Phi();
-    t_llm=ll.M();
-    t_llm_raw=ll_raw.M();
-    t_dphi=TMath::Abs(selLeptons[0].p4.DeltaPhi(selLeptons[1].p4));
-    t_deta=fabs(selLeptons[0].p4.Eta()-selLeptons[1].p4.Eta());
-    t_sumeta=selLeptons[0].p4.Eta()+selLeptons[1].p4.Eta();
-    int dilCode(selLeptons[0].id*selLeptons[1].id);
-    TString dilCat("mm");
-    if(dilCode==11*13) dilCat="em";
-    if(dilCode==11*11) dilCat="ee";
-
-    //ee and mm events should come from the appropriate primary dataset
-    if(isSingleMuPD || isSingleMuPD || isMuSkimedMCPD || isEleSkimedMCPD) {
-      if(dilCode==11*11 && !isSingleElePD && !isEleSkimedMCPD) continue;
-      if(dilCode==13*13 && !isSingleMuPD && !isMuSkimedMCPD) continue;
-    }
+      //dilepton selection
+      TLorentzVector ll(selLeptons[0].p4+selLeptons[1].p4);
+      TLorentzVector ll_raw(selLeptons[0].p4*(selLeptons[0].rawpt/selLeptons[0].p4.Pt())+selLeptons[1].p4*(selLeptons[1].rawpt/selLeptons[1].p4.Pt()));
+      t_llpt=ll.Pt();
+      t_llpt_raw=ll_raw.Pt();
+      t_lleta=ll.Eta();
+      t_llphi=ll.Phi();
+      t_llm=ll.M();
+      t_llm_raw=ll_raw.M();
+      t_dphi=TMath::Abs(selLeptons[0].p4.DeltaPhi(selLeptons[1].p4));
+      t_deta=fabs(selLeptons[0].p4.Eta()-selLeptons[1].p4.Eta());
+      t_sumeta=selLeptons[0].p4.Eta()+selLeptons[1].p4.Eta();
+      int dilCode(selLeptons[0].id*selLeptons[1].id);
+      TString dilCat("mm");
+      if(dilCode==11*13) dilCat="em";
+      if(dilCode==11*11) dilCat="ee";
+
+      //ee and mm events should come from the appropriate primary dataset
+      if(isSingleMuPD || isSingleMuPD || isMuSkimedMCPD || isEleSkimedMCPD) {
+        if(dilCode==11*11 && !isSingleElePD && !isEleSkimedMCPD) continue;
+        if(dilCode==13*13 && !isSingleMuPD && !isMuSkimedMCPD) continue;
+      }
 
-    if(blind) {
-      bool isZ( dilCode!=11*13 && fabs(t_llm-91)<15);
-      int charge(selLeptons[0].charge*selLeptons[1].charge);
-      if(!isMC && !isZ && charge<0 && fForestTree.run>=326887) continue;
-    }      
+      if(blind) {
+        bool isZ( dilCode!=11*13 && fabs(t_llm-91)<15);
+        int charge(selLeptons[0].charge*selLeptons[1].charge);
+        if constexpr(Mode::mayBeData) if(!isMC && !isZ && charge<0 && fForestTree.run>=326887) continue;
+      }      
               
-    //analyze jets
-    std::vector<BtagInfo_t> pfJetsIdx;
-    std::vector<TLorentzVector> pfJetsP4;
-    int npfjets(0),npfbjets(0); 
-
-    // initialize all the counters
-    t_nbjet_sel = 0; 
-    t_nbjet_sel_jecup    = 0; t_nbjet_sel_jecdn    = 0;
-    t_nbjet_sel_jerup    = 0; t_nbjet_sel_jerdn    = 0;
-    t_nbjet_sel_bup      = 0; t_nbjet_sel_bdn      = 0;
-    t_nbjet_sel_udsgup   = 0; t_nbjet_sel_udsgdn   = 0;
-    t_nbjet_sel_quenchup = 0; t_nbjet_sel_quenchdn = 0;
-
-	
-    for(int jetIter = 0; jetIter < fForestJets.nref; jetIter++){
-
-      //at least two tracks
-      if(fForestJets.trackN[jetIter]<2) continue;
-
-      TLorentzVector jp4(0,0,0,0);
-      if(isMC){
-	JECMC.SetJetPT(fForestJets.rawpt[jetIter]);
-	JECMC.SetJetEta(fForestJets.jteta[jetIter]);
-	JECMC.SetJetPhi(fForestJets.jtphi[jetIter]);
-	jp4.SetPtEtaPhiM( JECMC.GetCorrectedPT(),fForestJets.jteta[jetIter],fForestJets.jtphi[jetIter],fForestJets.jtm[jetIter]);
-	JEUMC.SetJetPT(JECMC.GetCorrectedPT());
-	JEUMC.SetJetEta(fForestJets.jteta[jetIter]);
-	JEUMC.SetJetPhi(fForestJets.jtphi[jetIter]);
-      }
-      else{
-	JECData.SetJetPT(fForestJets.rawpt[jetIter]);
-	JECData.SetJetEta(fForestJets.jteta[jetIter]);
-	JECData.SetJetPhi(fForestJets.jtphi[jetIter]);
-	jp4.SetPtEtaPhiM( JECData.GetCorrectedPT(),fForestJets.jteta[jetIter],fForestJets.jtphi[jetIter],fForestJets.jtm[jetIter]);
-	JEUData.SetJetPT(JECMC.GetCorrectedPT());
-	JEUData.SetJetEta(fForestJets.jteta[jetIter]);
-	JEUData.SetJetPhi(fForestJets.jtphi[jetIter]);
+      //analyze jets
+      std::vector<BtagInfo_t> pfJetsIdx;
+      std::vector<TLorentzVector> pfJetsP4;
+      int npfjets(0),npfbjets(0); 
+
+      //invert the gen->reco match once per event (the last gen jet pointing to a reco jet wins)
+      std::vector<int> genIdxForReco(fForestJets.nref,-1);
+      if constexpr(Mode::mayBeMC) if(isMC) {
+        for(int genjetIter = 0; genjetIter < fForestJets.ngen; genjetIter++) {
+          int recoIdx(fForestJets.genmatchindex[genjetIter]);
+          if(recoIdx>=0 && recoIdx<fForestJets.nref) genIdxForReco[recoIdx]=genjetIter;
+        }
       }
 
-      float csvVal=fForestJets.discr_csvV2[jetIter];
-      int nsvtxTk=fForestJets.svtxntrk[jetIter];
-      float msvtx=fForestJets.svtxm[jetIter];
-
-      if(jp4.Pt()<20.) continue; // smaller pT cut here to avoid the full loop
-      if(fabs(jp4.Eta())>2.0) continue;
-      bool isBTagged(csvVal>csvWPList[csvWP]);      
-
-      // simple matching to the closest jet in dR. require at least dR < 0.3
-      TLorentzVector matchjp4(0,0,0,0);
-      int refFlavor(0),refFlavorForB(0);
-      if (isMC){
-        //std::vector<TLorentzVector> matchedJets;
-        for (int genjetIter = 0; genjetIter < fForestJets.ngen; genjetIter++){
-          if (jetIter == fForestJets.genmatchindex[genjetIter]) {
-            matchjp4.SetPtEtaPhiM( fForestJets.genpt[genjetIter],fForestJets.geneta[genjetIter],fForestJets.genphi[genjetIter],fForestJets.genm[genjetIter]);
+      //the calibration of the selected jets is computed once and shared by all the systematic counters
+      jetCalib.clear();
+      for(int jetIter = 0; jetIter < fForestJets.nref; jetIter++){
+
+        //at least two tracks
+        if(fForestJets.trackN[jetIter]<2) continue;
+
+        float rawpt(fForestJets.rawpt[jetIter]),eta(fForestJets.jteta[jetIter]),phi(fForestJets.jtphi[jetIter]);
+        float corrpt( isMC ? JECMCTable.getCorrectedPT(rawpt,eta,phi) : JECDataTable.getCorrectedPT(rawpt,eta,phi) );
+        TLorentzVector jp4(0,0,0,0);
+        jp4.SetPtEtaPhiM(corrpt,eta,phi,fForestJets.jtm[jetIter]);
+
+        float csvVal=fForestJets.discr_csvV2[jetIter];
+        int nsvtxTk=fForestJets.svtxntrk[jetIter];
+        float msvtx=fForestJets.svtxm[jetIter];
+
+        if(jp4.Pt()<20.) continue; // smaller pT cut here to avoid the full loop
+        if(fabs(jp4.Eta())>2.0) continue;
+        bool isBTagged(csvVal>csvWPList[csvWP]);      
+
+        // simple matching to the closest jet in dR. require at least dR < 0.3
+        GenJetKin_t matchjet = {0.,0.,0.,0.};
+        int refFlavor(0),refFlavorForB(0);
+        if constexpr(Mode::mayBeMC) if(isMC) {
+          int genjetIter(genIdxForReco[jetIter]);
+          if (genjetIter>=0) {
+            matchjet.pt  = fForestJets.genpt[genjetIter];
+            matchjet.eta = fForestJets.geneta[genjetIter];
+            matchjet.phi = fForestJets.genphi[genjetIter];
+            matchjet.m   = fForestJets.genm[genjetIter];
           }
-        }  
-        refFlavor=fForestJets.refparton_flavor[jetIter];
-        refFlavorForB=fForestJets.refparton_flavorForB[jetIter];
-      }
+          refFlavor=fForestJets.refparton_flavor[jetIter];
+          refFlavorForB=fForestJets.refparton_flavorForB[jetIter];
+        }
 
-      //cross clean wrt to leptons
-      if(jp4.DeltaR(selLeptons[0].p4)<0.4 || jp4.DeltaR(selLeptons[1].p4)<0.4) continue;
-      
-      pfJetsIdx.push_back(std::make_tuple(pfJetsP4.size(),nsvtxTk,msvtx,csvVal,matchjp4,refFlavor,refFlavorForB));
-      pfJetsP4.push_back(jp4);
-      npfjets++;
-      npfbjets += isBTagged;
-      
+        //cross clean wrt to leptons
+        if(jp4.DeltaR(selLeptons[0].p4)<0.4 || jp4.DeltaR(selLeptons[1].p4)<0.4) continue;
       
-      if (jp4.Pt() > 30. && isBTagged) t_nbjet_sel       += 1;
+        pfJetsIdx.push_back(std::make_tuple(pfJetsP4.size(),nsvtxTk,msvtx,csvVal,matchjet,refFlavor,refFlavorForB));
+        pfJetsP4.push_back(jp4);
+        jetCalib.add(rawpt,jp4.Pt(),jp4.Eta(),jp4.Phi(),isBTagged,abs(refFlavorForB)==5);
+        npfjets++;
+        npfbjets += isBTagged;
+      }
 
-      if (isMC){
+      //uncertainties, resolution, quenching and b-tag variations (MC only, data keeps the nominal values)
+      if constexpr(Mode::mayBeMC) if(isMC) {
 
-        if (jp4.Pt() > 30 * (1 + JEUMC.GetUncertainty().first) && isBTagged) t_nbjet_sel_jecup += 1;
-        if (jp4.Pt() > 30 * (1 - JEUMC.GetUncertainty().second) && isBTagged) t_nbjet_sel_jecdn += 1;
-        float cjer(0.);
-        if ( abs(refFlavorForB) ) cjer = 1. + (1.2 -1.) * (jp4.Pt() - matchjp4.Pt()) / jp4.Pt(); // hard coded 1.2
-        else cjer = rand->Gaus(1., 0.2);
+        std::vector<double> jpt(jetCalib.pt.begin(),jetCalib.pt.end()), jeta(jetCalib.eta.begin(),jetCalib.eta.end());
+        std::vector<std::pair<double,double> > jecUnc=JEUMC.GetUncertainties(jpt,jeta);
 
-        if (jp4.Pt()*cjer > 30. && isBTagged) t_nbjet_sel_jerup += 1;
-        if (jp4.Pt()/cjer > 30. && isBTagged) t_nbjet_sel_jerdn += 1;
+        // make the quenching centrality dependent
+        float centralitySuppression = cenCtx.quenchSuppression;
 
-        quenchingModel->SetParameter(0, 50.); // this sets the omega_c parameter. if we want to make this centrality dependent
-        float tmp_quench_loss = quenchingModel->GetRandom();
-        tmp_quench_loss = TMath::Abs(TMath::Sin(jp4.Theta())*tmp_quench_loss); // make it only on the transverse part...
-        // make it centrality dependent
-        float centralitySuppression = centralityModel->Eval(cenBin/100.);
-        //
-        // std::cout << "energy loss " << tmp_quench_loss << " due to quenching " << std::endl;
-        // std::cout << "jet has eta " << jp4.Eta() << std::endl;
-        // std::cout << "pT loss     " << TMath::Abs(TMath::Sin(jp4.Theta())*tmp_quench_loss) << " due to quenching " << std::endl;
-        // std::cout << "pT loss centrality dependen    " << TMath::Abs(TMath::Sin(jp4.Theta())*tmp_quench_loss)*centralitySuppression << " (cen/supp) " << cenBin << " / " << centralitySuppression << std::endl << std::endl;
-
-        if (jp4.Pt()                  > 30. && isBTagged) t_nbjet_sel_quenchup += 1;
-        if (jp4.Pt()-tmp_quench_loss*centralitySuppression  > 30. && isBTagged) t_nbjet_sel_quenchdn += 1;
-        ht.fill("jetptprequench" ,  jp4.Pt()                                      ,  plotWgt);
-        ht.fill("jetquenchloss"  ,  tmp_quench_loss*centralitySuppression         ,  plotWgt);
-        if (jp4.Pt()-tmp_quench_loss*centralitySuppression > 20.)  ht.fill("jetptpostquench",  jp4.Pt()-tmp_quench_loss*centralitySuppression,  plotWgt);
-
-        if (abs(refFlavorForB) == 5){
-            ht.fill("jetptprequenchB" ,  jp4.Pt()                                      ,  plotWgt);
-            ht.fill("jetquenchlossB"  ,  tmp_quench_loss*centralitySuppression         ,  plotWgt);
-            if (jp4.Pt()-tmp_quench_loss*centralitySuppression > 20.)  ht.fill("jetptpostquenchB",  jp4.Pt()-tmp_quench_loss*centralitySuppression,  plotWgt);
-        }
+        for(size_t ij=0; ij<jetCalib.size(); ij++) {
 
-        bool isBTaggedNew(0);
-        float tmp_btageff = btagEfficiencies(refFlavorForB, cenBin);
+          float jpt_ij(jetCalib.pt[ij]);
+          int refFlavorForB(std::get<6>(pfJetsIdx[ij]));
 
-        if (jp4.Pt() < 30.) continue;
-        t_nbjet_sel_bup    = t_nbjet_sel; t_nbjet_sel_bdn    = t_nbjet_sel;
-        t_nbjet_sel_udsgup = t_nbjet_sel; t_nbjet_sel_udsgdn = t_nbjet_sel;
+          jetCalib.jecUp[ij] = jecUnc[ij].first;
+          jetCalib.jecDn[ij] = jecUnc[ij].second;
 
-        if ( abs(refFlavorForB) == 5){
+          if ( abs(refFlavorForB) ) jetCalib.jerSF[ij] = 1. + (1.2 -1.) * (jpt_ij - std::get<4>(pfJetsIdx[ij]).pt) / jpt_ij; // hard coded 1.2
+          else jetCalib.jerSF[ij] = rand->Gaus(1., 0.2);
 
-          isBTaggedNew = isBTagged; 
-          myBTagUtil->modifyBTagsWithSF(isBTaggedNew, 1.05, tmp_btageff );
-          if (!isBTagged &&  isBTaggedNew) t_nbjet_sel_bup = t_nbjet_sel+1;
-          if ( isBTagged && !isBTaggedNew) t_nbjet_sel_bup = t_nbjet_sel-1;
+          float tmp_quench_loss = quenchingModel.sample(quenchOmegaC, ij); // the jet index is the counter, the loss is the same wherever the jet is sampled
+          tmp_quench_loss = TMath::Abs(TMath::Sin(pfJetsP4[ij].Theta())*tmp_quench_loss); // make it only on the transverse part...
+          jetCalib.quenchLoss[ij] = tmp_quench_loss*centralitySuppression;
 
-          isBTaggedNew = isBTagged; 
-          myBTagUtil->modifyBTagsWithSF(isBTaggedNew, 0.95, tmp_btageff );
-          if (!isBTagged &&  isBTaggedNew) t_nbjet_sel_bdn = t_nbjet_sel+1;
-          if ( isBTagged && !isBTaggedNew) t_nbjet_sel_bdn = t_nbjet_sel-1;
-        }
+          ht.fill("jetptprequench" ,  jpt_ij                                        ,  plotWgt);
+          ht.fill("jetquenchloss"  ,  jetCalib.quenchLoss[ij]                       ,  plotWgt);
+          if (jpt_ij-jetCalib.quenchLoss[ij] > 20.)  ht.fill("jetptpostquench",  jpt_ij-jetCalib.quenchLoss[ij],  plotWgt);
+
+          if (abs(refFlavorForB) == 5){
+              ht.fill("jetptprequenchB" ,  jpt_ij                                        ,  plotWgt);
+              ht.fill("jetquenchlossB"  ,  jetCalib.quenchLoss[ij]                       ,  plotWgt);
+              if (jpt_ij-jetCalib.quenchLoss[ij] > 20.)  ht.fill("jetptpostquenchB",  jpt_ij-jetCalib.quenchLoss[ij],  plotWgt);
+          }
 
-        else {
+          if (jpt_ij < 30.) continue;
 
-          isBTaggedNew = isBTagged; 
-          myBTagUtil->modifyBTagsWithSF(isBTaggedNew, 1.15, tmp_btageff );
-          if (!isBTagged &&  isBTaggedNew) t_nbjet_sel_udsgup = t_nbjet_sel+1;
-          if ( isBTagged && !isBTaggedNew) t_nbjet_sel_udsgup = t_nbjet_sel-1;
+          // b jets are varied with the b SFs, udsg and unmatched jets with the mistag SFs
+          bool isBTagged(jetCalib.btag[ij]), isB(jetCalib.isB[ij]);
+          float tmp_btageff = cenCtx.btagEfficiency(refFlavorForB);
 
-          isBTaggedNew = isBTagged; 
-          myBTagUtil->modifyBTagsWithSF(isBTaggedNew, 0.85, tmp_btageff );
-          if (!isBTagged &&  isBTaggedNew) t_nbjet_sel_udsgdn = t_nbjet_sel+1;
-          if ( isBTagged && !isBTaggedNew) t_nbjet_sel_udsgdn = t_nbjet_sel-1;
+          bool isBTaggedNew(isBTagged);
+          myBTagUtil->modifyBTagsWithSF(isBTaggedNew, isB ? 1.05 : 1.15, tmp_btageff );
+          jetCalib.btagUp[ij] = isBTaggedNew;
 
+          isBTaggedNew = isBTagged;
+          myBTagUtil->modifyBTagsWithSF(isBTaggedNew, isB ? 0.95 : 0.85, tmp_btageff );
+          jetCalib.btagDn[ij] = isBTaggedNew;
         }
       }
-    }
-
-    // set the bjet variations to the nominal one for data
-    if (!isMC){
-      t_nbjet_sel_jecup    = t_nbjet_sel; t_nbjet_sel_jecdn    = t_nbjet_sel;
-      t_nbjet_sel_jerup    = t_nbjet_sel; t_nbjet_sel_jerdn    = t_nbjet_sel;
-      t_nbjet_sel_bup      = t_nbjet_sel; t_nbjet_sel_bdn      = t_nbjet_sel;
-      t_nbjet_sel_udsgup   = t_nbjet_sel; t_nbjet_sel_udsgdn   = t_nbjet_sel;
-      t_nbjet_sel_quenchup = t_nbjet_sel; t_nbjet_sel_quenchdn = t_nbjet_sel;
-    }
-
-    std::sort(pfJetsIdx.begin(),       pfJetsIdx.end(),      orderByBtagInfo);
+      jetCalib.finalize();
+
+      t_nbjet_sel = jetCalib.countBJets(JetCalibrationCache::NOMINAL, 30.);
+
+      //per-source JEC counters: only b-tagged jets can enter, all sources from a single lookup
+      if(hasJECSourceSyst) {
+        std::fill(nbjetJECSources.begin(),nbjetJECSources.end(),0);
+        for(size_t ij=0; ij<jetCalib.size(); ij++) {
+          if(!jetCalib.btag[ij]) continue;
+          const std::vector<float> &unc=JEUSources.eval(jetCalib.pt[ij],jetCalib.eta[ij]);
+          for(size_t isrc=0; isrc<JEUSources.size(); isrc++) {
+            nbjetJECSources[2*isrc]   += (jetCalib.pt[ij] > 30*(1+unc[2*isrc]));
+            nbjetJECSources[2*isrc+1] += (jetCalib.pt[ij] > 30*(1-unc[2*isrc+1]));
+          }
+        }
+      }
+      systOutput.compute();
+      std::sort(pfJetsIdx.begin(),       pfJetsIdx.end(),      orderByBtagInfo);
 
-    //for gen fill again fiducial counters
-    if(isMC) {      
+      //for gen fill again fiducial counters
+      if constexpr(Mode::mayBeMC) if(isMC) {      
       
-      bool isMatchedDilepton(abs(genDileptonCat)==abs(dilCode));
-      if( (genDileptonCat==11*11 && etrig==0) || (genDileptonCat==13*13 && mtrig==0)) 
-        isMatchedDilepton=false;
-
-      std::vector<TString> fidCats;
-      fidCats.push_back( isMatchedDilepton   ? "lep"    : "fakelep" );
-      if(npfbjets>0) {
-        fidCats.push_back( isMatchedDilepton && is1bFiducial ? "lep1b" : "fakelep1b" );
-        if(npfbjets>1) {
-          fidCats.push_back( isMatchedDilepton && is2bFiducial ? "lep2b" : "fakelep2b" );
-        }
-      }    
+        bool isMatchedDilepton(abs(genDileptonCat)==abs(dilCode));
+        if( (genDileptonCat==11*11 && etrig==0) || (genDileptonCat==13*13 && mtrig==0)) 
+          isMatchedDilepton=false;
+
+        std::vector<TString> fidCats;
+        fidCats.push_back( isMatchedDilepton   ? "lep"    : "fakelep" );
+        if(npfbjets>0) {
+          fidCats.push_back( isMatchedDilepton && is1bFiducial ? "lep1b" : "fakelep1b" );
+          if(npfbjets>1) {
+            fidCats.push_back( isMatchedDilepton && is2bFiducial ? "lep2b" : "fakelep2b" );
+          }
+        }    
       
-      for(size_t i=0; i<meIdxList.size(); i++) {
-        Double_t iwgt(fForestTree.ttbar_w->size()<i || fForestTree.ttbar_w->size() == 0 ? 1. : fForestTree.ttbar_w->at(meIdxList[i]));
-        ht.fill2D("fidcounter",0,i,iwgt,fidCats);
-        if(isGenDilepton)    ht.fill2D("fidcounter",1,i,iwgt,fidCats);
-        if(isLeptonFiducial) ht.fill2D("fidcounter",2,i,iwgt,fidCats);
-        if(is1bFiducial)     ht.fill2D("fidcounter",3,i,iwgt,fidCats);
-        if(is2bFiducial)     ht.fill2D("fidcounter",4,i,iwgt,fidCats);
+        ht.fillRows(h_fidcounter,ht.categoryMask(fidCats),fidSteps,meWgts);
       }
-    }
 
 
-    //define categories for pre-selection control histograms
-    std::vector<TString> categs;
-    categs.push_back(dilCat);
+      //define categories for pre-selection control histograms
+      std::vector<TString> categs;
+      categs.push_back(dilCat);
     
-    std::vector<TString> addCategs;
+      std::vector<TString> addCategs;
     
-    //monitor after run where EE scale shift changed
-    if(!isPP){
+      //monitor after run where EE scale shift changed
+      if constexpr(Mode::mayBePbPb) if(!isPP) {
+        addCategs.clear();
+        TString pf( fForestTree.run>=firstEEScaleShiftRun ? "after" : "before" );
+        for(auto c : categs) {
+          addCategs.push_back(c); addCategs.push_back(c+pf); 
+        }
+        categs=addCategs;
+      }
+
+      //monitor according to the b-tagging category
       addCategs.clear();
-      TString pf( fForestTree.run>=firstEEScaleShiftRun ? "after" : "before" );
-      for(auto c : categs) {
-        addCategs.push_back(c); addCategs.push_back(c+pf); 
+      TString pfbcat(Form("%dpfb",min(npfbjets,2)));
+      for(auto c : categs) { 
+        addCategs.push_back(c); 
+        if(npfbjets==0) addCategs.push_back(c+"0pfb"); 
+        if(npfbjets>0) addCategs.push_back(c+"geq1pfb"); 
       }
       categs=addCategs;
-    }
-
-    //monitor according to the b-tagging category
-    addCategs.clear();
-    TString pfbcat(Form("%dpfb",min(npfbjets,2)));
-    for(auto c : categs) { 
-      addCategs.push_back(c); 
-      if(npfbjets==0) addCategs.push_back(c+"0pfb"); 
-      if(npfbjets>0) addCategs.push_back(c+"geq1pfb"); 
-    }
-    categs=addCategs;
+      HistTool::CategoryMask catMask(ht.categoryMask(categs));
 
         
-    //fill histograms
-    for(int i=0; i<2; i++) {
-      TString pf(Form("l%d",i+1));
-      float pt(selLeptons[i].p4.Pt());
-      ht.fill(pf+"pt",             pt,                            plotWgt, categs);
-      ht.fill(pf+"eta",            fabs(selLeptons[i].p4.Eta()),  plotWgt, categs);
-      ht.fill(pf+"chiso",          selLeptons[i].chiso,           plotWgt, categs);
-      ht.fill(pf+"phoiso",         selLeptons[i].phoiso,          plotWgt, categs);
-      ht.fill(pf+"nhiso",          selLeptons[i].nhiso,           plotWgt, categs);
+      //fill histograms
+      for(int i=0; i<2; i++) {
+        float pt(selLeptons[i].p4.Pt());
+        ht.fill(h_lpt[i],            catMask, pt,                            plotWgt);
+        ht.fill(h_leta[i],           catMask, fabs(selLeptons[i].p4.Eta()),  plotWgt);
+        ht.fill(h_lchiso[i],         catMask, selLeptons[i].chiso,           plotWgt);
+        ht.fill(h_lphoiso[i],        catMask, selLeptons[i].phoiso,          plotWgt);
+        ht.fill(h_lnhiso[i],         catMask, selLeptons[i].nhiso,           plotWgt);
 
-    }
+      }
 
-    ht.fill( "acopl",     1-fabs(t_dphi)/TMath::Pi(),                   plotWgt, categs);
-    ht.fill( "detall",    t_deta,                                       plotWgt, categs);
-    ht.fill( "drll",      selLeptons[0].p4.DeltaR(selLeptons[1].p4),    plotWgt, categs);
-    ht.fill( "mll",       t_llm,                                        plotWgt, categs);
-    ht.fill( "ptll",      t_llpt,                                       plotWgt, categs);
-    ht.fill( "ptsum",     selLeptons[0].p4.Pt()+selLeptons[1].p4.Pt(),  plotWgt, categs);
-
-    //PF jets
-    ht.fill( "npfjets",   npfjets,   plotWgt, categs);
-    ht.fill( "npfbjets",  npfbjets,  plotWgt, categs);
-    std::vector<TLorentzVector> pfFinalState;
-    pfFinalState.push_back(selLeptons[0].p4);
-    pfFinalState.push_back(selLeptons[1].p4);
-    for(size_t ij=0; ij<min(pfJetsIdx.size(),size_t(2)); ij++) {     
-      int idx(std::get<0>(pfJetsIdx[ij]));
-      int ntks(std::get<1>(pfJetsIdx[ij]));
-      float svm(std::get<2>(pfJetsIdx[ij]));
-      float csv(std::get<3>(pfJetsIdx[ij]));
-      TLorentzVector p4=pfJetsP4[idx];
-      if(csv>csvWPList[csvWP]) pfFinalState.push_back(p4);
-      TString ppf(ij==0 ? "1" : "2");
-      ht.fill( "pf"+ppf+"jbalance", p4.Pt()/ll.Pt(), plotWgt, categs);
-      ht.fill( "pf"+ppf+"jpt",      p4.Pt(),         plotWgt, categs);
-      ht.fill( "pf"+ppf+"jeta",     fabs(p4.Eta()),  plotWgt, categs);
-      ht.fill( "pf"+ppf+"jsvtxm",   ntks,            plotWgt, categs);
-      ht.fill( "pf"+ppf+"jsvtxntk", svm,             plotWgt, categs);
-      ht.fill( "pf"+ppf+"jcsv",     csv,             plotWgt, categs);
-      ht.fill2D( "pf"+ppf+"jetavsphi",   p4.Eta(),p4.Phi(),   plotWgt, categs);
-
-
-      quenchingModel->SetParameter(0, 50.); // this sets the omega_c parameter. if we want to make this centrality dependent
-      float tmp_quench_loss = quenchingModel->GetRandom();
-      tmp_quench_loss = TMath::Abs(TMath::Sin(p4.Theta())*tmp_quench_loss); // make it only on the transverse part...
-      // make it centrality dependent
-      float centralitySuppression = centralityModel->Eval(cenBin/100.);
-      float quenchedPt=p4.Pt()-tmp_quench_loss*centralitySuppression;
-      ht.fill2D("jptvsjptquench", p4.Pt(), quenchedPt, plotWgt,categs);
-    }
+      ht.fill( h_acopl,     catMask, 1-fabs(t_dphi)/TMath::Pi(),                   plotWgt);
+      ht.fill( h_detall,    catMask, t_deta,                                       plotWgt);
+      ht.fill( h_drll,      catMask, selLeptons[0].p4.DeltaR(selLeptons[1].p4),    plotWgt);
+      ht.fill( h_mll,       catMask, t_llm,                                        plotWgt);
+      ht.fill( h_ptll,      catMask, t_llpt,                                       plotWgt);
+      ht.fill( h_ptsum,     catMask, selLeptons[0].p4.Pt()+selLeptons[1].p4.Pt(),  plotWgt);
+
+      //PF jets
+      ht.fill( h_npfjets,   catMask, npfjets,   plotWgt);
+      ht.fill( h_npfbjets,  catMask, npfbjets,  plotWgt);
+      std::vector<TLorentzVector> pfFinalState;
+      pfFinalState.push_back(selLeptons[0].p4);
+      pfFinalState.push_back(selLeptons[1].p4);
+      for(size_t ij=0; ij<min(pfJetsIdx.size(),size_t(2)); ij++) {     
+        int idx(std::get<0>(pfJetsIdx[ij]));
+        int ntks(std::get<1>(pfJetsIdx[ij]));
+        float svm(std::get<2>(pfJetsIdx[ij]));
+        float csv(std::get<3>(pfJetsIdx[ij]));
+        TLorentzVector p4=pfJetsP4[idx];
+        if(csv>csvWPList[csvWP]) pfFinalState.push_back(p4);
+        ht.fill( h_jbalance[ij], catMask, p4.Pt()/ll.Pt(), plotWgt);
+        ht.fill( h_jpt[ij],      catMask, p4.Pt(),         plotWgt);
+        ht.fill( h_jeta[ij],     catMask, fabs(p4.Eta()),  plotWgt);
+        ht.fill( h_jsvtxm[ij],   catMask, ntks,            plotWgt);
+        ht.fill( h_jsvtxntk[ij], catMask, svm,             plotWgt);
+        ht.fill( h_jcsv[ij],     catMask, csv,             plotWgt);
+        ht.fill2D( h_jetavsphi[ij], catMask, p4.Eta(),p4.Phi(), plotWgt);
+
+
+        float tmp_quench_loss = quenchingModel.sample(quenchOmegaC, idx); // same loss as in the jet loop
+        tmp_quench_loss = TMath::Abs(TMath::Sin(p4.Theta())*tmp_quench_loss); // make it only on the transverse part...
+        // make it centrality dependent
+        float centralitySuppression = cenCtx.quenchSuppression;
+        float quenchedPt=p4.Pt()-tmp_quench_loss*centralitySuppression;
+        ht.fill2D(h_jptvsjptquench, catMask, p4.Pt(), quenchedPt, plotWgt);
+      }
 
 
 
     
-    std::vector<float> rapMoments=getRapidityMoments(pfFinalState);
-    ht.fill( "pfrapavg",     rapMoments[0], plotWgt, categs);
-    ht.fill( "pfraprms",     rapMoments[1], plotWgt, categs);
-    ht.fill( "pfrapmaxspan", rapMoments[2], plotWgt, categs);
-    float pfht(0.);
-    TLorentzVector vis(0,0,0,0);
-    for(auto p : pfFinalState) { vis+=p; pfht+=p.Pt(); }
-    ht.fill( "pfht",         pfht, plotWgt, categs);
-    ht.fill( "pfmht",        vis.Pt(), plotWgt, categs);
-
-    // for tree filling set all the proper variables
-    t_run    = fForestTree.run;
-    t_lumi   = fForestTree.lumi;
-    t_event  = fForestTree.evt;
-    t_vx     = fForestTree.vx;
-    t_vy     = fForestTree.vy;
-    t_vz     = fForestTree.vz;
-    t_weight = plotWgt;
-    t_meWeights.clear();
-    if(isMC){
-      t_meWeights.push_back(topPtWgt);
-      t_meWeights.push_back(1./topPtWgt);
-      t_meWeights.push_back(topMassUpWgt);
-      t_meWeights.push_back(topMassDnWgt);
-      if(fForestTree.ttbar_w->size()>0) {
-        float nomWgt=fForestTree.ttbar_w->at(meIdxList[0]);
-        for(auto meIdx : meIdxList){
-          if(meIdx< fForestTree.ttbar_w->size()){
-            t_meWeights.push_back( fForestTree.ttbar_w->at(meIdx)/nomWgt );
+      std::vector<float> rapMoments=getRapidityMoments(pfFinalState);
+      ht.fill( h_pfrapavg,     catMask, rapMoments[0], plotWgt);
+      ht.fill( h_pfraprms,     catMask, rapMoments[1], plotWgt);
+      ht.fill( h_pfrapmaxspan, catMask, rapMoments[2], plotWgt);
+      float pfht(0.);
+      TLorentzVector vis(0,0,0,0);
+      for(auto p : pfFinalState) { vis+=p; pfht+=p.Pt(); }
+      ht.fill( h_pfht,         catMask, pfht, plotWgt);
+      ht.fill( h_pfmht,        catMask, vis.Pt(), plotWgt);
+
+      // for tree filling set all the proper variables
+      t_run    = fForestTree.run;
+      t_lumi   = fForestTree.lumi;
+      t_event  = fForestTree.evt;
+      t_vx     = fForestTree.vx;
+      t_vy     = fForestTree.vy;
+      t_vz     = fForestTree.vz;
+      t_weight = plotWgt;
+      if constexpr(Mode::mayBeMC) if(isMC) {
+        meStored.push_back(topPtWgt);
+        meStored.push_back(1./topPtWgt);
+        meStored.push_back(topMassUpWgt);
+        meStored.push_back(topMassDnWgt);
+        if(meCompressor.reduceHessian()) {
+          const std::vector<float> &reduced=meCompressor.compress(meRatios);
+          meStored.insert(meStored.end(),reduced.begin(),reduced.end());
+        }
+        else if(fForestTree.ttbar_w->size()>0) {
+          float nomWgt=fForestTree.ttbar_w->at(meIdxList[0]);
+          for(auto meIdx : meIdxList){
+            if(meIdx< fForestTree.ttbar_w->size()){
+              meStored.push_back( fForestTree.ttbar_w->at(meIdx)/nomWgt );
+            }
           }
         }
+        else {meStored.push_back(1.0); } 
+      }
+      t_nmeWeights = std::min(meStored.size(),maxMEWeights);
+      t_meWeights.clear();
+      t_meWeightsPacked.clear();
+      for(auto r : meStored) {
+        if(!packMEWeights) { t_meWeights.push_back(r); continue; }
+        if(!std::isfinite(r))
+          diagnostics().report("[make2Ltree] non-finite ME weight ratio stored as MEWeightCompressor::PACKNAN",r);
+        else if(!MEWeightCompressor::isPackable(r))
+          diagnostics().report("[make2Ltree] ME weight ratio saturated in the packed storage",r);
+        t_meWeightsPacked.push_back(MEWeightCompressor::pack(r));
       }
-      else {t_meWeights.push_back(1.0); } 
-    }
         
-    //centrality
-    t_cenbin   = cenBin;
-    t_ncollWgt = ncoll;
-
-    t_globalrho = globalrho;
-    t_etrig  = etrig;
-    t_mtrig  = mtrig;
-
-    //trigger scale factor
-    t_trigSF    = 1.0;
-    t_trigSFUnc = 0.;
-
-    //get expected trigger efficiencies and measured scale factors
-    std::vector<std::pair<float,float>  > ltrigEff, ltrigSF;
-    for(size_t ilep=0; ilep<2; ilep++){
-      float pt(selLeptons[ilep].p4.Pt()),eta(selLeptons[ilep].p4.Eta()),abseta(fabs(eta));
-
-      if(abs(selLeptons[ilep].id)==11){
-        ltrigEff.push_back(  std::pair<float,float>(e_mctrigeff->Eval(pt),0.0) );
-        ltrigSF.push_back( eleEff.eval(pt, abseta<barrelEndcapEta[0], cenBin, true, false) ); //HLT (L1 is unity by definition in this trigger menu)
-      }else{
-
-        ltrigEff.push_back(  std::pair<float,float>(tnp_weight_trig_pbpb(pt,eta,cenBin),0.0) );
-        float mutrigSF=tnp_weight_trig_pbpb(pt,eta,cenBin,0);
-        float deltaTnp=max(fabs(mutrigSF-tnp_weight_trig_pbpb(pt,eta,cenBin,-1)),fabs(mutrigSF-tnp_weight_trig_pbpb(pt,eta,cenBin,-2)));
-        float deltaStat=max(fabs(mutrigSF-tnp_weight_trig_pbpb(pt,eta,cenBin,1)),fabs(mutrigSF-tnp_weight_trig_pbpb(pt,eta,cenBin,2)));
-        float deltaSF=sqrt(deltaTnp*deltaTnp+deltaStat*deltaStat);
-        ltrigSF.push_back(  std::pair<float,float>(mutrigSF,deltaSF)  );        
+      //centrality
+      t_cenbin   = cenBin;
+      t_ncollWgt = ncoll;
+
+      t_globalrho = globalrho;
+      t_etrig  = etrig;
+      t_mtrig  = mtrig;
+
+      //all lepton scale factors and the dilepton trigger scale factor
+      const EventSF_t &evSF=sfService.evaluate(selLeptons[0].id,selLeptons[0].p4,selLeptons[1].id,selLeptons[1].p4,cenBin);
+      t_trigSF    = evSF.trigSF;
+      t_trigSFUnc = evSF.trigSFUnc;
+
+      // fill the leptons ordered by pt
+      t_lep_pt    .clear();
+      t_lep_calpt .clear();
+      t_lep_eta   .clear();
+      t_lep_phi   .clear();
+      t_lep_pdgId .clear();
+      t_lep_idflags.clear();
+      t_lep_d0 .clear();
+      t_lep_d0err .clear();
+      t_lep_dz  .clear();
+      t_lep_charge.clear();
+      t_lep_chiso.clear();    
+      t_lep_phiso.clear();
+      t_lep_nhiso.clear();
+      t_lep_rho.clear();    
+      t_lep_isofull.clear();
+      t_lep_isofull20.clear();
+      t_lep_isofull25.clear();
+      t_lep_isofull30.clear();
+      t_lep_miniiso.clear();
+      t_lep_matched.clear();
+      t_lep_taufeeddown.clear();
+      t_lep_trigmatch.clear();
+      t_lepSF.clear();
+      t_lepSFUnc.clear();
+      t_lepIsoSF.clear();
+      t_lepIsoSFUnc.clear();
+      t_nlep = selLeptons.size();
+      if(flatBranches && t_nlep>int(maxLeptons)) {
+        diagnostics().report("[make2Ltree] leptons beyond the flat branch size are not stored",t_nlep);
+        t_nlep=maxLeptons;
       }
-    }
-
-    //trigeff = e1*e2 +e1*(1-e2)+e2*(1-e1), the rest is scale factor and error propagation
-    t_trigSF  = (ltrigSF[0].first*ltrigEff[0].first+ltrigSF[1].first*ltrigEff[1].first-ltrigSF[0].first*ltrigSF[1].first*ltrigEff[0].first*ltrigEff[1].first);
-    t_trigSF /= (           
-      ltrigEff[0].first+                 ltrigEff[1].first-                                  ltrigEff[0].first*ltrigEff[1].first);
-
-    t_trigSFUnc  = pow( ltrigSF[0].second*(ltrigEff[0].first-ltrigSF[1].first*ltrigEff[0].first*ltrigEff[1].first), 2 );
-    t_trigSFUnc += pow( ltrigSF[1].second*(ltrigEff[1].first-ltrigSF[0].first*ltrigEff[0].first*ltrigEff[1].first), 2 );
-    t_trigSFUnc  = sqrt(t_trigSFUnc);
-
-    // fill the leptons ordered by pt
-    t_lep_pt    .clear();
-    t_lep_calpt .clear();
-    t_lep_eta   .clear();
-    t_lep_phi   .clear();
-    t_lep_pdgId .clear();
-    t_lep_idflags.clear();
-    t_lep_d0 .clear();
-    t_lep_d0err .clear();
-    t_lep_dz  .clear();
-    t_lep_charge.clear();
-    t_lep_chiso.clear();    
-    t_lep_phiso.clear();
-    t_lep_nhiso.clear();
-    t_lep_rho.clear();    
-    t_lep_isofull.clear();
-    t_lep_isofull20.clear();
-    t_lep_isofull25.clear();
-    t_lep_isofull30.clear();
-    t_lep_miniiso.clear();
-    t_lep_matched.clear();
-    t_lep_taufeeddown.clear();
-    t_lep_trigmatch.clear();
-    t_lepSF.clear();
-    t_lepSFUnc.clear();
-    t_lepIsoSF.clear();
-    t_lepIsoSFUnc.clear();
-    t_nlep = selLeptons.size();
-    t_lep_ind1 = -1;
-    t_lep_ind2 = -1;
-    for (int ilep = 0; ilep < t_nlep; ++ilep){
-      t_lep_pt    .push_back( selLeptons[ilep].rawpt  );
-      t_lep_calpt .push_back( selLeptons[ilep].p4.Pt()  );
-      t_lep_eta   .push_back( selLeptons[ilep].p4.Eta() );
-      t_lep_phi   .push_back( selLeptons[ilep].p4.Phi() );
-      t_lep_idflags.push_back(selLeptons[ilep].idFlags);
-      t_lep_d0    .push_back( selLeptons[ilep].d0 );
-      t_lep_d0err .push_back( selLeptons[ilep].d0err);
-      t_lep_dz    .push_back( selLeptons[ilep].dz  );
-      t_lep_chiso .push_back( selLeptons[ilep].chiso );
-      t_lep_phiso .push_back( selLeptons[ilep].phoiso );
-      t_lep_nhiso .push_back( selLeptons[ilep].nhiso );
-      t_lep_rho   .push_back( selLeptons[ilep].rho );
-      t_lep_pdgId .push_back( selLeptons[ilep].id );
-      t_lep_charge.push_back( selLeptons[ilep].charge );
-      t_lep_isofull.push_back( selLeptons[ilep].isofull );
-      t_lep_isofull20.push_back( selLeptons[ilep].isofullR[0] );
-      t_lep_isofull25.push_back( selLeptons[ilep].isofullR[1] );
-      t_lep_isofull30.push_back( selLeptons[ilep].isofullR[2] );
-      t_lep_miniiso.push_back( selLeptons[ilep].miniiso );
-      t_lep_matched.push_back( selLeptons[ilep].isMatched );
-      t_lep_taufeeddown.push_back( selLeptons[ilep].isTauFeedDown );
-      t_lep_trigmatch.push_back( selLeptons[ilep].isTrigMatch );
+      t_lep_ind1 = -1;
+      t_lep_ind2 = -1;
+      for (int ilep = 0; ilep < t_nlep; ++ilep){
+        t_lep_pt    .push_back( selLeptons[ilep].rawpt  );
+        t_lep_calpt .push_back( selLeptons[ilep].p4.Pt()  );
+        t_lep_eta   .push_back( selLeptons[ilep].p4.Eta() );
+        t_lep_phi   .push_back( selLeptons[ilep].p4.Phi() );
+        t_lep_idflags.push_back(selLeptons[ilep].idFlags);
+        t_lep_d0    .push_back( selLeptons[ilep].d0 );
+        t_lep_d0err .push_back( selLeptons[ilep].d0err);
+        t_lep_dz    .push_back( selLeptons[ilep].dz  );
+        t_lep_chiso .push_back( selLeptons[ilep].chiso );
+        t_lep_phiso .push_back( selLeptons[ilep].phoiso );
+        t_lep_nhiso .push_back( selLeptons[ilep].nhiso );
+        t_lep_rho   .push_back( selLeptons[ilep].rho );
+        t_lep_pdgId .push_back( selLeptons[ilep].id );
+        t_lep_charge.push_back( selLeptons[ilep].charge );
+        t_lep_isofull.push_back( selLeptons[ilep].isofull );
+        t_lep_isofull20.push_back( selLeptons[ilep].isofullR[0] );
+        t_lep_isofull25.push_back( selLeptons[ilep].isofullR[1] );
+        t_lep_isofull30.push_back( selLeptons[ilep].isofullR[2] );
+        t_lep_miniiso.push_back( selLeptons[ilep].miniiso );
+        t_lep_matched.push_back( selLeptons[ilep].isMatched );
+        t_lep_taufeeddown.push_back( selLeptons[ilep].isTauFeedDown );
+        t_lep_trigmatch.push_back( selLeptons[ilep].isTrigMatch );
       
-      //reco/tracking+id scale factors
-      float sfVal(1.0),sfValUnc(0.0);
-      if(abs(selLeptons[ilep].id)==13) {
-	//ID
-        sfVal=tnp_weight_muid_pbpb( selLeptons[ilep].p4.Eta(), 0 );                         //central value
-        sfValUnc += pow(fabs(tnp_weight_muid_pbpb( selLeptons[ilep].p4.Eta(),+1)-sfVal),2); //stat, +1 sigma
-        sfValUnc += pow(fabs(tnp_weight_muid_pbpb( selLeptons[ilep].p4.Eta(),-1)-sfVal),2); //stat, -1 sigma
-	sfValUnc += pow(fabs(tnp_weight_muid_pbpb( selLeptons[ilep].p4.Eta(),+2)-sfVal),2); //syst, +1 sigma                                                                                         
-	sfValUnc += pow(fabs(tnp_weight_muid_pbpb( selLeptons[ilep].p4.Eta(),-2)-sfVal),2); //syst, -1 sigma
-	sfValUnc += pow(0.01,2);                                                            //identification centrality dependence
-	//Tracking
-	sfVal*=tnp_weight_glbtrk_pbpb( selLeptons[ilep].p4.Eta(), cenBin,0 );                      //central value                                                                                
-	sfValUnc += pow(fabs(tnp_weight_glbtrk_pbpb( selLeptons[ilep].p4.Eta(),cenBin,+1)-sfVal),2); //stat, +1 sigma                                                                                 
-	sfValUnc += pow(fabs(tnp_weight_glbtrk_pbpb( selLeptons[ilep].p4.Eta(),cenBin,-1)-sfVal),2); //stat, -1 sigma                                                                                    
-	sfValUnc += pow(fabs(tnp_weight_glbtrk_pbpb( selLeptons[ilep].p4.Eta(),cenBin,+2)-sfVal),2); //syst, +1 sigma                                                                                    
-	sfValUnc += pow(fabs(tnp_weight_glbtrk_pbpb( selLeptons[ilep].p4.Eta(),cenBin,-2)-sfVal),2); //syst, -1 sigma                                                                                    
-	sfValUnc = sqrt(sfValUnc);
-      }else {
-        std::pair<float,float > eleIDsf=eleEff.eval(selLeptons[ilep].p4.Pt(), fabs(selLeptons[ilep].p4.Eta())<barrelEndcapEta[0], cenBin, false, false); //ID
-        sfVal=eleIDsf.first;
-        sfValUnc=eleIDsf.second;
-        std::pair<float,float > eleRECOsf=eleEff.eval(selLeptons[ilep].p4.Pt(), fabs(selLeptons[ilep].p4.Eta())<barrelEndcapEta[0], cenBin, false, true); //RECO                                     
-        sfValUnc = sqrt(pow(sfValUnc/sfVal,2)+pow(eleRECOsf.second/eleRECOsf.first,2));
-        sfVal*=eleRECOsf.first;
-      }    
-      t_lepSF.push_back(sfVal);
-      t_lepSFUnc.push_back(sfValUnc);
-
-      TString isoKey(cenBin<30 ? "cen" : "periph");
-      isoKey+=abs(selLeptons[ilep].id)==13 ? "_169" : "_121";
-      Int_t xbin=isoEffSFs[isoKey]->GetXaxis()->FindBin( min(selLeptons[ilep].p4.Pt(), isoEffSFs[isoKey]->GetXaxis()->GetXmax()-0.01) );
-      Int_t ybin=isoEffSFs[isoKey]->GetYaxis()->FindBin( min(fabs(selLeptons[ilep].p4.Eta()), isoEffSFs[isoKey]->GetYaxis()->GetXmax()) );
-      if (isoEffSFs[isoKey]->GetBinContent(xbin,ybin) != 0.){
-        t_lepIsoSF   .push_back( isoEffSFs[isoKey]->GetBinContent(xbin,ybin) );
-        t_lepIsoSFUnc.push_back( isoEffSFs[isoKey]->GetBinError  (xbin,ybin) );
-      } else{
-        t_lepIsoSF   .push_back( 1.00);
-        t_lepIsoSFUnc.push_back( 0.05);
-      }
-
-      //isolation-based indices
-      bool isIso(true);
-      if(abs(selLeptons[ilep].id)==13) {
-        float rho=selLeptons[ilep].rho;
-        float ue=0.00102*pow(rho+12.6255,2)+0.18535*(rho+12.6255);
-        float iso=(selLeptons[ilep].isofull-ue)/selLeptons[ilep].p4.Pt();
-        if(iso>0.12) isIso=false;
-      }else {
-        float rho=selLeptons[ilep].rho;
-        float ue=0.000817*pow(rho+14.696,2)+0.201661*(rho+14.696);
-        float iso=(selLeptons[ilep].isofull-ue)/selLeptons[ilep].p4.Pt();
-        if(iso>0.) isIso=false;
+        //reco/tracking+id and isolation scale factors (already evaluated for the leading pair)
+        LeptonSF_t lepSF;
+        if(ilep<2) lepSF=evSF.lep[ilep];
+        else       sfService.evaluate(selLeptons[ilep].id,selLeptons[ilep].p4,cenBin,lepSF);
+        t_lepSF.push_back(lepSF.sf);
+        t_lepSFUnc.push_back(lepSF.sfUnc);
+        t_lepIsoSF   .push_back( lepSF.isoSF    );
+        t_lepIsoSFUnc.push_back( lepSF.isoSFUnc );
+
+        //isolation-based indices
+        bool isIso(true);
+        if(abs(selLeptons[ilep].id)==13) {
+          float rho=selLeptons[ilep].rho;
+          float ue=0.00102*pow(rho+12.6255,2)+0.18535*(rho+12.6255);
+          float iso=(selLeptons[ilep].isofull-ue)/selLeptons[ilep].p4.Pt();
+          if(iso>0.12) isIso=false;
+        }else {
+          float rho=selLeptons[ilep].rho;
+          float ue=0.000817*pow(rho+14.696,2)+0.201661*(rho+14.696);
+          float iso=(selLeptons[ilep].isofull-ue)/selLeptons[ilep].p4.Pt();
+          if(iso>0.) isIso=false;
+        }
+        if(isIso && t_lep_ind1 < 0)                    t_lep_ind1 = ilep;
+        if(isIso && t_lep_ind1 > -1 && t_lep_ind2 < 0) t_lep_ind2 = ilep;
       }
-      if(isIso && t_lep_ind1 < 0)                    t_lep_ind1 = ilep;
-      if(isIso && t_lep_ind1 > -1 && t_lep_ind2 < 0) t_lep_ind2 = ilep;
-    }
     
-    // fill the jets ordered by b-tag
-    t_bjet_leadPassTight=false;
-    t_bjet_pt   .clear();
-    t_bjet_eta  .clear();
-    t_bjet_phi  .clear();
-    t_bjet_mass .clear();
-    t_bjet_csvv2.clear();
-    t_bjet_matchpt  .clear();
-    t_bjet_matcheta .clear();
-    t_bjet_matchphi .clear();
-    t_bjet_matchmass.clear();
-    t_bjet_flavor.clear();
-    t_bjet_flavorForB.clear();
-    t_nbjet = pfJetsIdx.size();
-    for (int ij = 0; ij < t_nbjet; ij++) {
-      int idx = std::get<0>(pfJetsIdx[ij]);
-      t_bjet_pt   .push_back( pfJetsP4[idx].Pt()  );
-      t_bjet_eta  .push_back( pfJetsP4[idx].Eta() );
-      t_bjet_phi  .push_back( pfJetsP4[idx].Phi() );
-      t_bjet_mass .push_back( pfJetsP4[idx].M()   );
-      t_bjet_csvv2.push_back( std::get<3>(pfJetsIdx[ij])   );      
-      t_bjet_matchpt  .push_back( std::get<4>(pfJetsIdx[ij]).Pt());
-      t_bjet_matcheta .push_back( std::get<4>(pfJetsIdx[ij]).Eta());
-      t_bjet_matchphi .push_back( std::get<4>(pfJetsIdx[ij]).Phi());
-      t_bjet_matchmass.push_back( std::get<4>(pfJetsIdx[ij]).M());
-      t_bjet_flavor.push_back( std::get<5>(pfJetsIdx[ij]) );
-      t_bjet_flavorForB.push_back( std::get<6>(pfJetsIdx[ij]) );
-    }
+      // fill the jets ordered by b-tag
+      t_bjet_leadPassTight=false;
+      t_bjet_pt   .clear();
+      t_bjet_eta  .clear();
+      t_bjet_phi  .clear();
+      t_bjet_mass .clear();
+      t_bjet_csvv2.clear();
+      t_bjet_matchpt  .clear();
+      t_bjet_matcheta .clear();
+      t_bjet_matchphi .clear();
+      t_bjet_matchmass.clear();
+      t_bjet_flavor.clear();
+      t_bjet_flavorForB.clear();
+      t_nbjet = pfJetsIdx.size();
+      if(flatBranches && t_nbjet>int(maxJets)) {
+        diagnostics().report("[make2Ltree] jets beyond the flat branch size are not stored",t_nbjet);
+        t_nbjet=maxJets;
+      }
+      for (int ij = 0; ij < t_nbjet; ij++) {
+        int idx = std::get<0>(pfJetsIdx[ij]);
+        t_bjet_pt   .push_back( pfJetsP4[idx].Pt()  );
+        t_bjet_eta  .push_back( pfJetsP4[idx].Eta() );
+        t_bjet_phi  .push_back( pfJetsP4[idx].Phi() );
+        t_bjet_mass .push_back( pfJetsP4[idx].M()   );
+        t_bjet_csvv2.push_back( std::get<3>(pfJetsIdx[ij])   );      
+        t_bjet_matchpt  .push_back( std::get<4>(pfJetsIdx[ij]).pt);
+        t_bjet_matcheta .push_back( std::get<4>(pfJetsIdx[ij]).eta);
+        t_bjet_matchphi .push_back( std::get<4>(pfJetsIdx[ij]).phi);
+        t_bjet_matchmass.push_back( std::get<4>(pfJetsIdx[ij]).m);
+        t_bjet_flavor.push_back( std::get<5>(pfJetsIdx[ij]) );
+        t_bjet_flavorForB.push_back( std::get<6>(pfJetsIdx[ij]) );
+      }
 
 
-    t_ht  = pfht;
-    t_mht = vis.Pt();
+      t_ht  = pfht;
+      t_mht = vis.Pt();
     
-    // // now set the 4 variables that we added for the tmva reader for the bdt evaluation
-    // bdt_l1pt      = t_lep_calpt[0];
-    // bdt_apt       = (t_lep_calpt[0]-t_lep_calpt[1])/(t_lep_calpt[0]+t_lep_calpt[1]);
-    // bdt_abslleta  = fabs(t_lleta);
-    // bdt_dphilll2  = fabs(dphi_2(t_lep_calpt[0],t_lep_eta[0],t_lep_phi[0],t_lep_calpt[1],t_lep_eta[1],t_lep_phi[1],2)); // this function is in functions.cc in scripts/
-    // bdt_sumabseta = fabs(t_lep_eta[0])+fabs(t_lep_eta[1]);
-    // //bdt_flavor    = abs(t_lep_pdgId[0]*t_lep_pdgId[1]); //abs should be fine here, it's an int
-    // t_apt         = bdt_apt;
-    // t_dphilll2    = bdt_dphilll2;
-    // t_bdt         = reader->EvaluateMVA( methodName );
-    // t_bdt_rarity  = reader->GetRarity  ( methodName );
-    // t_fisher2     = readerFisher2->EvaluateMVA( methodNameFisher2 );
-    t_bjet_leadPassTight = (t_bjet_csvv2.size()>0 && t_bjet_csvv2[0]>csvWPList[1]);
-    t_isData = !isMC;
+      // // now set the 4 variables that we added for the tmva reader for the bdt evaluation
+      // bdt_l1pt      = t_lep_calpt[0];
+      // bdt_apt       = (t_lep_calpt[0]-t_lep_calpt[1])/(t_lep_calpt[0]+t_lep_calpt[1]);
+      // bdt_abslleta  = fabs(t_lleta);
+      // bdt_dphilll2  = fabs(dphi_2(t_lep_calpt[0],t_lep_eta[0],t_lep_phi[0],t_lep_calpt[1],t_lep_eta[1],t_lep_phi[1],2)); // this function is in functions.cc in scripts/
+      // bdt_sumabseta = fabs(t_lep_eta[0])+fabs(t_lep_eta[1]);
+      // //bdt_flavor    = abs(t_lep_pdgId[0]*t_lep_pdgId[1]); //abs should be fine here, it's an int
+      // t_apt         = bdt_apt;
+      // t_dphilll2    = bdt_dphilll2;
+      // t_bdt         = reader->EvaluateMVA( methodName );
+      // t_bdt_rarity  = reader->GetRarity  ( methodName );
+      // t_fisher2     = readerFisher2->EvaluateMVA( methodNameFisher2 );
+      t_bjet_leadPassTight = (t_bjet_csvv2.size()>0 && t_bjet_csvv2[0]>csvWPList[1]);
+      t_isData = !isMC;
     
-    outTree->Fill();
+      if(fillOutput) {
+        outTree->Fill();
+        systOutput.fill();
+      }
+    }
+  };
+
+  //run the loop for the mode of this job and report the time per event
+  std::chrono::steady_clock::time_point loopStart(std::chrono::steady_clock::now());
+  runEventLoop(isMC,isPP,gtEra,eventLoop);
+  double loopTime(std::chrono::duration<double>(std::chrono::steady_clock::now()-loopStart).count());
+  cout << "[make2Ltree] event loop mode isMC=" << isMC << " isPP=" << isPP << " era=" << gtEra
+       << ": " << nEntries << " events in " << loopTime << " s"
+       << " (" << 1.e3*loopTime/TMath::Max(nEntries,1) << " ms/event)" << endl;
+
+  //benchmark: time the loop of this mode against the loop with the flags tested at run time,
+  //after the pass above (which warms up the input) and without changing the output: the trees are not filled,
+  //the histograms are filled in a throwaway copy and the weight sums and diagnostics are restored afterwards
+  if(benchmarkLoop) {
+    RuntimeLoopMode::isMC=isMC;
+    RuntimeLoopMode::isPP=isPP;
+    RuntimeLoopMode::era=gtEra;
+    fillOutput=false;
+    std::vector<HistShard> scratch(ht.makeShards(1));
+    ht.swapContents(scratch[0]);
+    Double_t wgtSumSaved(wgtSum);
+    std::vector<Double_t> allWgtSumSaved(allWgtSum), storedWgtSumSaved(storedWgtSum);
+    CountedDiagnostics diagnosticsSaved(diagnostics());
+
+    //passes in the order specialised, runtime, runtime, specialised, the best time of each is kept
+    double specialisedTime(-1), runtimeTime(-1);
+    for(int ipass=0; ipass<4; ipass++) {
+      bool specialised(ipass==0 || ipass==3);
+      std::chrono::steady_clock::time_point passStart(std::chrono::steady_clock::now());
+      if(specialised) runEventLoop(isMC,isPP,gtEra,eventLoop);
+      else            eventLoop(RuntimeLoopMode());
+      double passTime(std::chrono::duration<double>(std::chrono::steady_clock::now()-passStart).count());
+      double &best(specialised ? specialisedTime : runtimeTime);
+      best = best<0 ? passTime : TMath::Min(best,passTime);
+    }
+
+    ht.swapContents(scratch[0]);
+    wgtSum=wgtSumSaved;
+    allWgtSum=allWgtSumSaved;
+    storedWgtSum=storedWgtSumSaved;
+    diagnostics()=diagnosticsSaved;
+    fillOutput=true;
+
+    cout << "[make2Ltree] loop benchmark (best of 2 passes each, not written to the output): "
+         << "specialised " << 1.e3*specialisedTime/TMath::Max(nEntries,1) << " ms/event, "
+         << "runtime branching " << 1.e3*runtimeTime/TMath::Max(nEntries,1) << " ms/event, "
+         << "ratio " << specialisedTime/TMath::Max(runtimeTime,1e-9) << endl;
   }
 
-  //save histos to file  
-  if(outURL!=""){
-    TFile *fOut=TFile::Open(outURL,"RECREATE");
-    fOut->cd();
+  //before the histograms are converted and written
+  if(memoryReport) ht.printMemoryReport();
 
+  //save histos to file  
+  if(fOut){
+    outTree->GetDirectory()->cd();
     outTree->Write();
+    systOutput.write();
+    fOut->cd();
 
     //store the weight sum for posterior normalization
     TH1D *wgtH=new TH1D("wgtsum","wgtsum",1,0,1);
@@ -1730,16 +1826,54 @@ int main(int argc, char* argv[])
       allwgtH->SetBinContent(i+1,allWgtSum[i]);
     allwgtH->SetDirectory(fOut);
     allwgtH->Write();
-    for (auto& it : ht.getPlots())  { 
-      if(it.second->GetEntries()==0) continue;
-      it.second->SetDirectory(fOut); it.second->Write(); 
+
+    //with reduced Hessian sets, the sums of the stored ME weights (after the first 4 top weights)
+    if(storedWgtSum.size()) {
+      std::vector<std::string> storedLabels(meCompressor.labels(meIdxList.size()));
+      TH1D *storedwgtH=new TH1D("storedwgtsum","storedwgtsum",storedWgtSum.size(),0,storedWgtSum.size());
+      for(size_t i=0; i<storedWgtSum.size(); i++) {
+        storedwgtH->SetBinContent(i+1,storedWgtSum[i]);
+        if(i<storedLabels.size()) storedwgtH->GetXaxis()->SetBinLabel(i+1,storedLabels[i].c_str());
+      }
+      storedwgtH->SetDirectory(fOut);
+      storedwgtH->Write();
     }
-    for (auto& it : ht.get2dPlots())  { 
-      if(it.second->GetEntries()==0) continue;
-      it.second->SetDirectory(fOut); it.second->Write(); 
+    ht.write(fOut);
+
+    //copy the selected events with each policy and report the cost of writing and reading them
+    if(benchmarkOutput) {
+      cout << "[make2Ltree] output benchmark with " << outTree->GetEntries() << " entries" << endl;
+      for(auto &pname : OutputPolicy::names()) {
+        TString tmpURL(outURL);
+        tmpURL.ReplaceAll(".root",TString("_benchmark_")+pname+".root");
+        if(tmpURL==outURL) tmpURL+=TString("_benchmark_")+pname+".root";
+        OutputPolicy::Benchmark_t res=OutputPolicy(pname).benchmark(outTree,tmpURL,outMultiplicity);
+        cout << "\t" << res.policy << ": write " << res.writeTime << " s, "
+             << res.fileSize/1024. << " kB, read " << res.readTime << " s" << endl;
+      }
     }
     fOut->Close();
+
+    if(fTree) {
+      fTree->Close();
+      bool converted(RNTupleOutput::convert(treeURL,"tree",outURL));
+      for(auto &var : systOutput.variations())
+        converted &= RNTupleOutput::convert(treeURL,var->treeName(),outURL);
+      if(converted) {
+        cout << "[make2Ltree] tree stored as an RNTuple in " << outURL << endl;
+        if(benchmarkOutput) {
+          RNTupleOutput::ReadBenchmark_t res=RNTupleOutput::benchmarkRead(treeURL,outURL,"tree");
+          cout << "[make2Ltree] read benchmark (dilepton+b selection): TTree " << res.treeTime << " s (sumw=" << res.treeSumw << "), "
+               << "RNTuple " << res.ntupleTime << " s (sumw=" << res.ntupleSumw << ")" << endl;
+        }
+        gSystem->Unlink(treeURL);
+      }
+      else
+        cout << "[make2Ltree] the tree is kept in " << treeURL << endl;
+    }
   }
 
+  diagnostics().printSummary();
+
   return 0;
 }
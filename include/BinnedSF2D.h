@@ -0,0 +1,81 @@
+#ifndef BinnedSF2D_h
+#define BinnedSF2D_h
+
+#include "TH2.h"
+#include <algorithm>
+#include <vector>
+
+/**
+   @short 2D binned scale factor copied from a TH2 into contiguous arrays
+
+   The bin edges, contents and errors (including under/overflow) are copied at load time
+   so that the evaluation is two binary searches and an array read.
+   Each axis can clamp values above its range to the last bin; otherwise they fall in the
+   overflow bin as with TH1::FindBin. Values below the range always fall in the underflow bin.
+ */
+class BinnedSF2D
+{
+
+ public:
+
+  BinnedSF2D() : nx_(0), ny_(0), clampX_(false), clampY_(false) { }
+
+  BinnedSF2D(const TH2 *h, bool clampX=false, bool clampY=false) { load(h,clampX,clampY); }
+
+  void load(const TH2 *h, bool clampX=false, bool clampY=false)
+  {
+    clampX_=clampX;
+    clampY_=clampY;
+    xEdges_.clear(); yEdges_.clear(); val_.clear(); err_.clear();
+    nx_=h->GetNbinsX();
+    ny_=h->GetNbinsY();
+    for(int i=1; i<=nx_+1; i++) xEdges_.push_back(h->GetXaxis()->GetBinLowEdge(i));
+    for(int j=1; j<=ny_+1; j++) yEdges_.push_back(h->GetYaxis()->GetBinLowEdge(j));
+    for(int j=0; j<=ny_+1; j++) {
+      for(int i=0; i<=nx_+1; i++) {
+        val_.push_back(h->GetBinContent(i,j));
+        err_.push_back(h->GetBinError(i,j));
+      }
+    }
+  }
+
+  bool isValid() const { return nx_>0 && ny_>0; }
+
+  /**
+     @short returns the (content,error) of the bin containing (x,y)
+   */
+  std::pair<float,float> eval(float x, float y) const
+  {
+    if(!isValid()) return std::pair<float,float>(0.,0.);
+    size_t idx(findBin(yEdges_,ny_,y,clampY_)*(nx_+2)+findBin(xEdges_,nx_,x,clampX_));
+    return std::pair<float,float>(val_[idx],err_[idx]);
+  }
+
+  /**
+     @short batch version of eval
+   */
+  std::vector<std::pair<float,float> > eval(const std::vector<float> &x, const std::vector<float> &y) const
+  {
+    std::vector<std::pair<float,float> > result;
+    result.reserve(x.size());
+    for(size_t i=0; i<x.size() && i<y.size(); i++) result.push_back(eval(x[i],y[i]));
+    return result;
+  }
+
+ private:
+
+  //bin index with the TH1 conventions: 0 underflow, 1..n, n+1 overflow (n if clamped)
+  static int findBin(const std::vector<double> &edges, int n, double v, bool clamp)
+  {
+    if(v<edges[0])  return 0;
+    if(v>=edges[n]) return clamp ? n : n+1;
+    return int(std::upper_bound(edges.begin(),edges.end(),v)-edges.begin());
+  }
+
+  int nx_, ny_;
+  bool clampX_, clampY_;
+  std::vector<double> xEdges_, yEdges_;
+  std::vector<float> val_, err_;
+};
+
+#endif
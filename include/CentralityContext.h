@@ -0,0 +1,121 @@
+#ifndef CentralityContext_h
+#define CentralityContext_h
+
+#include "TF1.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/**
+   @short centrality-dependent corrections of an event, all resolved from its hiBin
+ */
+struct CentralityContext {
+  int hiBin;                 //-1 for pp
+  float cenBin;              //centrality in %
+  bool isCentral;            //hiBin<30
+  float ncoll;               //Glauber Ncoll x normalization of the sample (1 for pp)
+  float quenchSuppression;   //centrality model of the jet quenching, evaluated at cenBin
+  float eleScale[2];         //electron energy scale [barrel,endcap]
+  float eleSmear[2];         //electron energy smearing in GeV at the Z peak [barrel,endcap] (MC only)
+  float btagEff[3];          //expected b-tagging efficiency [b,unmatched,udsg]
+
+  int eleRegion(float eta) const { return fabs(eta)<1.45 ? 0 : 1; }
+
+  float btagEfficiency(int flavor) const
+  {
+    if(abs(flavor)==5) return btagEff[0];
+    if(flavor==0)      return btagEff[1];
+    return btagEff[2];
+  }
+};
+
+/**
+   @short table of the centrality contexts, filled once per job for each of the 200 hiBins
+
+   All the parameterizations which depend on the centrality (Glauber Ncoll, quenching suppression,
+   electron scale and smearing, b-tagging efficiencies) are evaluated at construction so that
+   the event loop resolves them with a single lookup.
+ */
+class CentralityTable
+{
+
+ public:
+
+  static const int NHIBINS=200;
+
+  /**
+     @short CTOR - the quenching suppression model is evaluated at cenBin/100
+     ncollWgtNorm normalizes the Ncoll weights to the number of events processed
+   */
+  CentralityTable(bool isMC, bool isPP, double ncollWgtNorm, TF1 *suppressionModel, int csvWP) :
+    isPP_(isPP)
+    {
+      for(int hiBin=0; hiBin<NHIBINS; hiBin++) {
+        CentralityContext ctx;
+        ctx.hiBin=hiBin;
+        ctx.cenBin=0.5*hiBin;
+        ctx.isCentral=(hiBin<30);
+        ctx.ncoll=glauberNcoll(hiBin)*ncollWgtNorm;
+        fill(ctx,isMC,suppressionModel,csvWP);
+        table_.push_back(ctx);
+      }
+
+      pp_.hiBin=-1;
+      pp_.cenBin=0.;
+      pp_.isCentral=false;
+      pp_.ncoll=1.;
+      fill(pp_,isMC,suppressionModel,csvWP);
+    }
+
+  /**
+     @short returns the context for a hiBin (the pp one if the table was built for pp)
+   */
+  const CentralityContext &get(int hiBin) const
+  {
+    if(isPP_) return pp_;
+    return table_[std::min(std::max(hiBin,0),NHIBINS-1)];
+  }
+
+  /**
+     @short parameterization from Glauber MC
+   */
+  static double glauberNcoll(int hiBin)
+  {
+    static const double Ncoll[NHIBINS] = {1976.95, 1944.02, 1927.29, 1891.9, 1845.3, 1807.2, 1760.45, 1729.18, 1674.8, 1630.3, 1590.52, 1561.72, 1516.1, 1486.5, 1444.68, 1410.88, 1376.4, 1347.32, 1309.71, 1279.98, 1255.31, 1219.89, 1195.13, 1165.96, 1138.92, 1113.37, 1082.26, 1062.42, 1030.6, 1009.96, 980.229, 955.443, 936.501, 915.97, 892.063, 871.289, 847.364, 825.127, 806.584, 789.163, 765.42, 751.187, 733.001, 708.31, 690.972, 677.711, 660.682, 640.431, 623.839, 607.456, 593.307, 576.364, 560.967, 548.909, 530.475, 519.575, 505.105, 490.027, 478.133, 462.372, 451.115, 442.642, 425.76, 416.364, 405.154, 392.688, 380.565, 371.167, 360.28, 348.239, 340.587, 328.746, 320.268, 311.752, 300.742, 292.172, 281.361, 274.249, 267.025, 258.625, 249.931, 240.497, 235.423, 228.63, 219.854, 214.004, 205.425, 199.114, 193.618, 185.644, 180.923, 174.289, 169.641, 161.016, 157.398, 152.151, 147.425, 140.933, 135.924, 132.365, 127.017, 122.127, 117.817, 113.076, 109.055, 105.16, 101.323, 98.098, 95.0548, 90.729, 87.6495, 84.0899, 80.2237, 77.2201, 74.8848, 71.3554, 68.7745, 65.9911, 63.4136, 61.3859, 58.1903, 56.4155, 53.8486, 52.0196, 49.2921, 47.0735, 45.4345, 43.8434, 41.7181, 39.8988, 38.2262, 36.4435, 34.8984, 33.4664, 31.8056, 30.351, 29.2074, 27.6924, 26.7754, 25.4965, 24.2802, 22.9651, 22.0059, 21.0915, 19.9129, 19.1041, 18.1487, 17.3218, 16.5957, 15.5323, 14.8035, 14.2514, 13.3782, 12.8667, 12.2891, 11.61, 11.0026, 10.3747, 9.90294, 9.42648, 8.85324, 8.50121, 7.89834, 7.65197, 7.22768, 6.7755, 6.34855, 5.98336, 5.76555, 5.38056, 5.11024, 4.7748, 4.59117, 4.23247, 4.00814, 3.79607, 3.68702, 3.3767, 3.16309, 2.98282, 2.8095, 2.65875, 2.50561, 2.32516, 2.16357, 2.03235, 1.84061, 1.72628, 1.62305, 1.48916, 1.38784, 1.28366, 1.24693, 1.18552, 1.16085, 1.12596, 1.09298, 1.07402, 1.06105, 1.02954};
+    return Ncoll[std::min(std::max(hiBin,0),NHIBINS-1)];
+  }
+
+ private:
+
+  //fills the corrections which only depend on cenBin
+  static void fill(CentralityContext &ctx, bool isMC, TF1 *suppressionModel, int csvWP)
+  {
+    float cen(ctx.cenBin);
+    int icen(cen<10. ? 0 : (cen<30. ? 1 : 2));
+
+    ctx.quenchSuppression = suppressionModel ? suppressionModel->Eval(cen/100.) : 1.;
+
+    //https://twiki.cern.ch/twiki/pub/CMS/HiEgamma2019/electron-aa-scalesmear-190918.pdf
+    //indexed by [barrel,endcap][cen<10,cen<30,other]
+    static const float scaleMC[2][3]   = { {0.971, 0.990, 1.003}, {0.910, 0.951, 0.988} };
+    static const float scaleData[2][3] = { {0.989, 1.006, 1.016}, {0.967, 1.018, 1.054} };
+    static const float smearMC[2][3]   = { {1.19113, 1.28262, 2.20549}, {3.13988, 3.15340, 3.17194} };
+    for(int ireg=0; ireg<2; ireg++) {
+      ctx.eleScale[ireg] = isMC ? scaleMC[ireg][icen] : scaleData[ireg][icen];
+      ctx.eleSmear[ireg] = isMC ? smearMC[ireg][icen] : 0.;
+    }
+
+    //btag efficiencies from the AN, indexed by [csvWP][b,unmatched,udsg][cen<=30,other]
+    static const float btagEff[2][3][2] = { { {0.556, 0.683}, {0.057, 0.042}, {0.023, 0.008} },
+                                            { {0.385, 0.546}, {0.013, 0.008}, {0.005, 0.001} } };
+    for(int iflav=0; iflav<3; iflav++)
+      ctx.btagEff[iflav] = btagEff[csvWP==0 ? 0 : 1][iflav][cen<=30 ? 0 : 1];
+  }
+
+  bool isPP_;
+  std::vector<CentralityContext> table_;
+  CentralityContext pp_;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef CountedDiagnostics_h
+#define CountedDiagnostics_h
+
+#include <iostream>
+#include <map>
+#include <string>
+
+/**
+   @short rate-limited diagnostics: each distinct condition is printed once and counted afterwards
+
+   Conditions are identified by their message. The first occurrence is printed with the value
+   which triggered it, the following ones are only counted and reported by printSummary().
+ */
+class CountedDiagnostics
+{
+
+ public:
+
+  CountedDiagnostics() { }
+
+  /**
+     @short reports occurrences of a condition (nOccurrences>1 for occurrences counted elsewhere, e.g. per worker)
+   */
+  void report(const std::string &condition, double value, unsigned long nOccurrences=1)
+  {
+    if(nOccurrences==0) return;
+    unsigned long &n=counts_[condition];
+    if(n==0)
+      std::cout << condition << " (first occurrence: " << value << ", further ones are only counted)" << std::endl;
+    n+=nOccurrences;
+  }
+
+  unsigned long count(const std::string &condition) const
+  {
+    std::map<std::string,unsigned long>::const_iterator it=counts_.find(condition);
+    return it==counts_.end() ? 0 : it->second;
+  }
+
+  void printSummary(std::ostream &out=std::cout) const
+  {
+    if(counts_.empty()) return;
+    out << "[CountedDiagnostics] summary of the conditions reported" << std::endl;
+    for(auto &it : counts_) out << "\t" << it.second << "x " << it.first << std::endl;
+  }
+
+  void clear() { counts_.clear(); }
+
+ private:
+  std::map<std::string,unsigned long> counts_;
+};
+
+/**
+   @short job-wide instance
+ */
+inline CountedDiagnostics &diagnostics()
+{
+  static CountedDiagnostics instance;
+  return instance;
+}
+
+#endif
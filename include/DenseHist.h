@@ -0,0 +1,256 @@
+#ifndef DenseHist_h
+#define DenseHist_h
+
+#include "TH1.h"
+#include "TH2.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+/**
+   @short lightweight 1D/2D histogram used while filling, converted to a TH1/TH2 at write time
+
+   The axes are copied from a prototype histogram and the bin contents, sum of squared weights,
+   number of entries and fill statistics are kept in contiguous arrays. Fill mirrors TH1::Fill/TH2::Fill
+   (same bin finding, float accumulation of the contents for TH1F/TH2F, statistics only for
+   in-range fills) so that fillInto reproduces the histogram that would have been filled directly.
+   As in ROOT, the contents of TH1F/TH2F are stored as floats and the sums of squared weights are
+   only allocated at the first weight different from 1 (or if the prototype has Sumw2), starting from
+   the contents, so the dense storage takes no more memory than the histogram it replaces.
+   Axes which ROOT extends on a numeric fill are not supported, see isSupported.
+   In sparse mode only the filled cells are stored (hash map), for large histograms which are
+   filled in a small fraction of their cells.
+ */
+class DenseHist
+{
+
+ public:
+
+  DenseHist() : nx_(0), ny_(0), xmin_(0), xmax_(0), ymin_(0), ymax_(0),
+                isFloat_(false), weighted_(false), statOverflows_(false), sparse_(false), entries_(0)
+  {
+    std::fill(stats_,stats_+7,0.);
+  }
+
+  DenseHist(const TH1 *proto, bool sparse=false) : DenseHist(proto,proto->InheritsFrom("TArrayF"),sparse) { }
+
+  /**
+     @short isFloat is proto->InheritsFrom("TArrayF"), for callers which cache it per prototype
+   */
+  DenseHist(const TH1 *proto, bool isFloat, bool sparse) : DenseHist()
+  {
+    const TAxis *xaxis=proto->GetXaxis();
+    nx_=xaxis->GetNbins();
+    xmin_=xaxis->GetXmin();
+    xmax_=xaxis->GetXmax();
+    if(xaxis->GetXbins()->GetSize()) xEdges_.assign(xaxis->GetXbins()->GetArray(),xaxis->GetXbins()->GetArray()+nx_+1);
+    if(proto->GetDimension()==2) {
+      const TAxis *yaxis=proto->GetYaxis();
+      ny_=yaxis->GetNbins();
+      ymin_=yaxis->GetXmin();
+      ymax_=yaxis->GetXmax();
+      if(yaxis->GetXbins()->GetSize()) yEdges_.assign(yaxis->GetXbins()->GetArray(),yaxis->GetXbins()->GetArray()+ny_+1);
+    }
+    isFloat_=isFloat;
+    statOverflows_=TH1::GetDefaultStatOverflows();
+    sparse_=sparse;
+    if(!sparse_) {
+      if(isFloat_) sumwF_.resize(nCells(),0.f);
+      else         sumw_.resize(nCells(),0.);
+    }
+    if(proto->GetSumw2N()) startWeights();
+  }
+
+  size_t nCells() const { return (nx_+2)*(ny_>0 ? ny_+2 : 1); }
+  bool isSparse() const { return sparse_; }
+  bool isWeighted() const { return weighted_; }
+
+  /**
+     @short approximate memory used by the contents
+   */
+  size_t memoryBytes() const
+  {
+    size_t bytes(sizeof(DenseHist)+(xEdges_.size()+yEdges_.size())*sizeof(double));
+    bytes += sumwF_.capacity()*sizeof(float) + (sumw_.capacity()+sumw2_.capacity())*sizeof(double);
+    bytes += cells_.size()*(sizeof(Cells_t::value_type)+2*sizeof(void *)) + cells_.bucket_count()*sizeof(void *);
+    return bytes;
+  }
+
+  /**
+     @short only axes which are not extended by a numeric fill can be filled in dense storage
+     (fully labelled axes are extendable but TAxis::FindBin does not extend alphanumeric axes)
+   */
+  static bool isSupported(const TH1 *proto)
+  {
+    if(proto->GetDimension()>2) return false;
+    if(isExtendedOnFill(proto->GetXaxis())) return false;
+    if(proto->GetDimension()==2 && isExtendedOnFill(proto->GetYaxis())) return false;
+    return true;
+  }
+
+  inline void fill(double x, double w)
+  {
+    entries_++;
+    int bin(findBin(x,nx_,xmin_,xmax_,xEdges_));
+    accumulate(bin,w);
+    if((bin==0 || bin>nx_) && !statOverflows_) return;
+    double z(w);
+    stats_[0] += z;
+    stats_[1] += z*z;
+    stats_[2] += z*x;
+    stats_[3] += z*x*x;
+  }
+
+  inline void fill(double x, double y, double w)
+  {
+    entries_++;
+    int binx(findBin(x,nx_,xmin_,xmax_,xEdges_)), biny(findBin(y,ny_,ymin_,ymax_,yEdges_));
+    accumulate(biny*(nx_+2)+binx,w);
+    if((binx==0 || binx>nx_) && !statOverflows_) return;
+    if((biny==0 || biny>ny_) && !statOverflows_) return;
+    double z(w);
+    stats_[0] += z;
+    stats_[1] += z*z;
+    stats_[2] += z*x;
+    stats_[3] += z*x*x;
+    stats_[4] += z*y;
+    stats_[5] += z*y*y;
+    stats_[6] += z*x*y;
+  }
+
+  /**
+     @short fills (x_j, i, w[i]) for each i and, for each i, each x_j in turn
+     equivalent to the corresponding sequence of fill(x,y,w) calls, with the x bins found once
+   */
+  void fillRows(const std::vector<double> &x, const std::vector<double> &w)
+  {
+    size_t nrows(x.size());
+    std::vector<int> &binx=rowBins_;
+    binx.resize(nrows);
+    for(size_t j=0; j<nrows; j++) binx[j]=findBin(x[j],nx_,xmin_,xmax_,xEdges_);
+
+    for(size_t i=0; i<w.size(); i++) {
+      double y(i), z(w[i]);
+      int biny(findBin(y,ny_,ymin_,ymax_,yEdges_));
+      bool yInRange(biny>0 && biny<=ny_);
+      for(size_t j=0; j<nrows; j++) {
+        entries_++;
+        accumulate(biny*(nx_+2)+binx[j],z);
+        if(!statOverflows_ && (!yInRange || binx[j]==0 || binx[j]>nx_)) continue;
+        double xj(x[j]);
+        stats_[0] += z;
+        stats_[1] += z*z;
+        stats_[2] += z*xj;
+        stats_[3] += z*xj*xj;
+        stats_[4] += z*y;
+        stats_[5] += z*y*y;
+        stats_[6] += z*xj*y;
+      }
+    }
+  }
+
+  double entries() const { return entries_; }
+
+  /**
+     @short adds the contents of a dense histogram with the same binning (as TH1::Add)
+   */
+  void add(const DenseHist &other)
+  {
+    //without squared weights the other contents are sums of unit weights (as TH1::Add using the errors)
+    if(other.weighted_ && !weighted_) startWeights();
+    for(size_t i=0; i<sumwF_.size(); i++) {
+      sumwF_[i] = float(double(sumwF_[i])+other.sumwF_[i]);
+      if(weighted_) sumw2_[i] += other.weighted_ ? other.sumw2_[i] : other.sumwF_[i];
+    }
+    for(size_t i=0; i<sumw_.size(); i++) {
+      sumw_[i] += other.sumw_[i];
+      if(weighted_) sumw2_[i] += other.weighted_ ? other.sumw2_[i] : other.sumw_[i];
+    }
+    for(auto &it : other.cells_) {
+      Cell_t &c=cells_[it.first];
+      c.sumw = isFloat_ ? float(c.sumw+it.second.sumw) : c.sumw+it.second.sumw;
+      if(weighted_) c.sumw2 += other.weighted_ ? it.second.sumw2 : it.second.sumw;
+    }
+    for(size_t i=0; i<7; i++) stats_[i] += other.stats_[i];
+    entries_ += other.entries_;
+  }
+
+  /**
+     @short copies the contents, errors, entries and statistics to a histogram with the same binning
+   */
+  void fillInto(TH1 *h) const
+  {
+    //AddBinContent on the reset histogram sets the content without side effects on the statistics
+    //(SetBinContent would inflate a labelled axis when setting the last bin)
+    if(weighted_ && h->GetSumw2N()==0) h->Sumw2();
+    for(size_t i=0; i<sumwF_.size(); i++) h->AddBinContent(i,sumwF_[i]);
+    for(size_t i=0; i<sumw_.size(); i++) h->AddBinContent(i,sumw_[i]);
+    for(auto &it : cells_) h->AddBinContent(it.first,it.second.sumw);
+    if(h->GetSumw2N()) {
+      TArrayD *sw2=h->GetSumw2();
+      if(weighted_)     std::copy(sumw2_.begin(),sumw2_.end(),sw2->fArray);
+      else if(isFloat_) std::copy(sumwF_.begin(),sumwF_.end(),sw2->fArray);
+      else              std::copy(sumw_.begin(),sumw_.end(),sw2->fArray);
+      for(auto &it : cells_) sw2->fArray[it.first] = weighted_ ? it.second.sumw2 : it.second.sumw;
+    }
+    double stats[7];
+    std::copy(stats_,stats_+7,stats);
+    h->PutStats(stats);
+    h->SetEntries(entries_);
+  }
+
+ private:
+
+  static bool isExtendedOnFill(const TAxis *axis) { return axis->CanExtend() && !axis->IsAlphanumeric(); }
+
+  //as TAxis::FindBin for an axis which is not extended
+  static inline int findBin(double x, int n, double xmin, double xmax, const std::vector<double> &edges)
+  {
+    if(x<xmin) return 0;
+    if(!(x<xmax)) return n+1;
+    if(edges.empty()) return 1+int(n*(x-xmin)/(xmax-xmin));
+    return int(std::upper_bound(edges.begin(),edges.end(),x)-edges.begin());
+  }
+
+  //as TH1::Sumw2 on a filled histogram: the squared weights of the unit fills so far are the contents
+  void startWeights()
+  {
+    weighted_=true;
+    if(sparse_) {
+      for(auto &it : cells_) it.second.sumw2=it.second.sumw;
+    }
+    else if(isFloat_) sumw2_.assign(sumwF_.begin(),sumwF_.end());
+    else              sumw2_=sumw_;
+  }
+
+  //as TH1::Fill, the squared weights are only needed once a weight differs from 1
+  inline void accumulate(int bin, double w)
+  {
+    if(w!=1.0 && !weighted_) startWeights();
+    if(sparse_) {
+      Cell_t &c=cells_[bin];
+      if(weighted_) c.sumw2 += w*w;
+      if(isFloat_) c.sumw = float(c.sumw)+float(w);
+      else         c.sumw += w;
+      return;
+    }
+    if(weighted_) sumw2_[bin] += w*w;
+    if(isFloat_) sumwF_[bin] += float(w);
+    else         sumw_[bin] += w;
+  }
+
+  int nx_, ny_;
+  double xmin_, xmax_, ymin_, ymax_;
+  std::vector<double> xEdges_, yEdges_;
+  bool isFloat_, weighted_, statOverflows_, sparse_;
+  double entries_, stats_[7];
+  std::vector<float> sumwF_;                                //dense mode, indexed by global bin: contents of TH1F/TH2F
+  std::vector<double> sumw_, sumw2_;                        //contents of the other histograms, squared weights once weighted_
+  struct Cell_t { double sumw, sumw2; Cell_t() : sumw(0), sumw2(0) { } };
+  typedef std::unordered_map<int,Cell_t> Cells_t;
+  Cells_t cells_;                                           //sparse mode, global bin -> contents
+  std::vector<int> rowBins_;   //scratch for fillRows
+};
+
+#endif
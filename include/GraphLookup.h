@@ -0,0 +1,79 @@
+#ifndef GraphLookup_h
+#define GraphLookup_h
+
+#include "TGraph.h"
+#include <algorithm>
+#include <vector>
+
+/**
+   @short copy of a TGraph evaluated with the linear interpolation of TGraph::Eval
+
+   The points are sorted at load time and a dense uniform grid in x maps each cell to the
+   first segment it overlaps, so that eval needs no search over the points.
+   Outside the range of the graph the first/last segment is extrapolated, as in TGraph::Eval.
+   eval is const and does not touch the original graph, which can be deleted after loading.
+ */
+class GraphLookup
+{
+
+ public:
+
+  GraphLookup() : xmin_(0), xmax_(0), invCell_(0) { }
+
+  GraphLookup(const TGraph *gr, int nCells=1000) { load(gr,nCells); }
+
+  void load(const TGraph *gr, int nCells=1000)
+  {
+    x_.clear(); y_.clear(); cellSegment_.clear();
+    xmin_=xmax_=invCell_=0;
+    if(gr==0 || gr->GetN()==0) return;
+
+    std::vector<std::pair<double,double> > pts;
+    for(int i=0; i<gr->GetN(); i++) pts.push_back(std::pair<double,double>(gr->GetX()[i],gr->GetY()[i]));
+    std::stable_sort(pts.begin(),pts.end(),
+                     [](const std::pair<double,double> &a,const std::pair<double,double> &b){ return a.first<b.first; });
+    for(auto &p : pts) { x_.push_back(p.first); y_.push_back(p.second); }
+
+    xmin_=x_.front();
+    xmax_=x_.back();
+    if(x_.size()<2 || xmax_<=xmin_) return;
+    nCells=std::max(nCells,1);
+    invCell_=nCells/(xmax_-xmin_);
+    for(int i=0; i<nCells; i++) {
+      double xlo(xmin_+i/invCell_);
+      size_t s=std::upper_bound(x_.begin(),x_.end(),xlo)-x_.begin();
+      cellSegment_.push_back(s>0 ? s-1 : 0);
+    }
+  }
+
+  bool isValid() const { return !x_.empty(); }
+
+  double eval(double x) const
+  {
+    size_t n(x_.size());
+    if(n==0) return 0.;
+    if(n==1) return y_[0];
+
+    //segment [low,low+1] containing x, extrapolating the first/last one outside the range
+    size_t low(0);
+    if(x>=xmax_) low=n-2;
+    else if(x>xmin_) {
+      size_t cell=std::min(size_t((x-xmin_)*invCell_),cellSegment_.size()-1);
+      low=cellSegment_[cell];
+      while(low>0 && x<x_[low]) low--;
+      while(low+2<n && x>=x_[low+1]) low++;
+    }
+    size_t up(low+1);
+    if(x==x_[low]) return y_[low];
+    if(x==x_[up])  return y_[up];
+    if(x_[low]==x_[up]) return y_[low];
+    return y_[up] + (x - x_[up]) * (y_[low] - y_[up]) / (x_[low] - x_[up]);
+  }
+
+ private:
+  double xmin_, xmax_, invCell_;
+  std::vector<double> x_, y_;
+  std::vector<size_t> cellSegment_;
+};
+
+#endif
@@ -7,22 +7,213 @@
 #include "TH2.h"
 #include "TString.h"
 
+#include "HeavyIonsAnalysis/topskim/include/CountedDiagnostics.h"
+#include "HeavyIonsAnalysis/topskim/include/DenseHist.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
 #include <map>
+#include <thread>
 #include <vector>
 
+class HistTool;
+
+/**
+   @short histogram contents filled by one worker, indexed by the handles and categories of a HistTool
+
+   A shard only reads the registry of the HistTool it was created from, so shards can be filled
+   concurrently without locks. Dense slots are started on first use; fills of histograms which
+   cannot be stored densely are recorded and replayed in order when the shard is synchronized.
+ */
+class HistShard {
+
+ public:
+
+  typedef uint64_t CategoryMask;
+
+  HistShard() : tool_(0), nDropped_(0) { }
+  HistShard(const HistTool *tool);
+
+  inline void fill(int handle, CategoryMask mask, double value, double weight);
+  inline void fill2D(int handle, CategoryMask mask, double valueX, double valueY, double weight);
+  inline void fillRows(int handle, CategoryMask mask, const std::vector<double> &valuesX, const std::vector<double> &weights);
+
+  /**
+     @short adds the contents of another shard of the same HistTool
+   */
+  void add(const HistShard &other);
+
+  /**
+     @short empties the shard, keeping the handle space
+   */
+  void clear();
+
+  /**
+     @short approximate memory used by the contents
+   */
+  size_t memoryBytes() const;
+
+ private:
+
+  friend class HistTool;
+
+  struct Replay_t { int slot; double x, y, w; };
+
+  inline DenseHist &denseSlot(int slot);
+
+  const HistTool *tool_;
+  unsigned long nDropped_;                             //fills of the categories beyond the maximum
+  std::vector<int> denseIdx_;                          //[handle*MAXCATEGORIES+category], index in denseSlots_ or -1
+  std::vector<std::pair<int,DenseHist> > denseSlots_;  //(slot,contents) in order of first use
+  std::vector<Replay_t> replay_;
+};
+
+/**
+   @short histogram registry with per-category copies
+
+   Histograms are registered once with addHist, which returns an integer handle, and categories
+   are interned once as integer ids (id 0 is the empty category, i.e. the registered histogram itself).
+   A fill takes the handle and a mask of category ids and indexes a dense table of histogram slots.
+   During the loop the slots are DenseHist objects started on first use; they are converted to the
+   registered histogram and its per-category clones only when the plots are requested (getPlots),
+   or one at a time while they are written (write), which releases each slot once it is written.
+   The TString based interface is kept and resolves the handle and the categories on each call.
+   Categories beyond the maximum share the last id, which is never filled: they are reported once
+   when they are interned and the fills they drop are counted in the diagnostics().
+
+   Large 2D histograms can be stored sparsely (setSparseThreshold) and the categories filled for
+   a histogram can be restricted with setCategoryAllowList, so that the memory does not grow as
+   categories x bins for histograms which only make sense in a few categories.
+
+   For multi-threaded filling, makeShards creates one HistShard per worker after all histograms
+   and categories are registered (the const categoryMask only looks up existing categories),
+   and fixes the storage of all the histograms, which is otherwise decided at their first fill.
+   merge reduces the shards pairwise in a fixed order, so the result does not depend on the
+   scheduling of the threads, and adds them to the contents of the tool.
+ */
 class HistTool {
 
  public:
-  HistTool() {}
+
+  typedef HistShard::CategoryMask CategoryMask;
+  static const int MAXCATEGORIES=64;
+  static const int OVERFLOWCATEGORY=MAXCATEGORIES-1;
+
+  HistTool() : sparseThreshold_(0) { addCategory(""); main_=HistShard(this); }
   ~HistTool() {}
-  
-  inline void addHist(TString title, TH1* hist) {
-    if(hist->InheritsFrom("TH2")) {
+
+  //the contents and the shards point to this registry: not copyable nor movable
+  HistTool(const HistTool &)=delete;
+  HistTool &operator=(const HistTool &)=delete;
+
+  inline int addHist(TString title, TH1* hist) {
+    if(handles_.count(title)) {
+      std::cout << "Histogram " << title << " already registered, ignoring." << std::endl;
+      return handles_[title];
+    }
+    int h(titles_.size());
+    bool is2D(hist->InheritsFrom("TH2"));
+    if(is2D) {
       all2dPlots_[title]=(TH2 *)hist;
     }
     else {
       allPlots_[title] = hist;
     }
+    handles_[title]=h;
+    titles_.push_back(title);
+    is2D_.push_back(is2D);
+    isFloat_.push_back(hist->InheritsFrom("TArrayF"));
+    isDense_.push_back(-1);
+    allowed_.push_back(~overflowMask());
+    slots_.resize(titles_.size()*MAXCATEGORIES,(TH1 *)0);
+    slots_[h*MAXCATEGORIES]=hist;
+    main_.denseIdx_.resize(slots_.size(),-1);
+    return h;
+  }
+
+  /**
+     @short handle of a registered histogram, -1 if not registered
+   */
+  inline int getHandle(const TString &title) const {
+    std::map<TString,int>::const_iterator it=handles_.find(title);
+    return it==handles_.end() ? -1 : it->second;
+  }
+
+  /**
+     @short interns a category and returns its id, OVERFLOWCATEGORY if the maximum number of categories is reached
+   */
+  inline int addCategory(const TString &cat) {
+    std::map<TString,int>::iterator it=categories_.find(cat);
+    if(it!=categories_.end()) return it->second;
+    if(int(catNames_.size())>=OVERFLOWCATEGORY) {
+      std::cout << "Category " << cat << " exceeds the maximum of " << OVERFLOWCATEGORY << " categories, its fills are dropped"
+                << " (counted in the diagnostics summary)." << std::endl;
+      categories_[cat]=OVERFLOWCATEGORY;
+      return OVERFLOWCATEGORY;
+    }
+    int id(catNames_.size());
+    categories_[cat]=id;
+    catNames_.push_back(cat);
+    for(auto &it : allowLists_)
+      if(std::find(it.second.begin(),it.second.end(),cat)==it.second.end()) allowed_[it.first] &= ~categoryMask(id);
+    return id;
+  }
+
+  /**
+     @short restricts the categories filled for a histogram (the registered histogram itself is always filled)
+   */
+  inline void setCategoryAllowList(const TString &title, const std::vector<TString> &cats) {
+    int h(getHandle(title));
+    if(h<0) return;
+    allowLists_[h]=cats;
+    allowed_[h]=CategoryMask(1);   //the registered histogram
+    for(auto &c : cats) allowed_[h] |= categoryMask(addCategory(c));
+    allowed_[h] &= ~overflowMask();
+  }
+
+  /**
+     @short 2D histograms with more cells than this are stored sparsely (0, the default, disables it)
+     applies to the copies started after the call
+   */
+  inline void setSparseThreshold(size_t nCells) { sparseThreshold_=nCells; }
+
+  inline CategoryMask categoryMask(int id) const { return id<0 ? 0 : CategoryMask(1)<<id; }
+  static CategoryMask overflowMask() { return CategoryMask(1)<<OVERFLOWCATEGORY; }
+  inline CategoryMask categoryMask(const TString &cat) { return categoryMask(addCategory(cat)); }
+  inline CategoryMask categoryMask(const std::vector<TString> &cats) {
+    CategoryMask mask(0);
+    for(auto &c : cats) mask |= categoryMask(c);
+    return mask;
+  }
+
+  /**
+     @short mask of already registered categories (unknown ones are ignored), safe to call from the workers
+   */
+  inline CategoryMask categoryMask(const TString &cat) const {
+    std::map<TString,int>::const_iterator it=categories_.find(cat);
+    return it==categories_.end() ? 0 : categoryMask(it->second);
+  }
+  inline CategoryMask categoryMask(const std::vector<TString> &cats) const {
+    CategoryMask mask(0);
+    for(auto &c : cats) mask |= categoryMask(c);
+    return mask;
+  }
+
+  inline void fill(int handle, CategoryMask mask, double value, double weight) {
+    main_.fill(handle,mask,value,weight);
+  }
+
+  inline void fill2D(int handle, CategoryMask mask, double valueX, double valueY, double weight) {
+    main_.fill2D(handle,mask,valueX,valueY,weight);
+  }
+
+  /**
+     @short fills a 2D counter with one weight per y bin: (x, i, weights[i]) for each x in valuesX
+     e.g. a set of selection steps in x for all the ME weights in y, in a single call per category
+   */
+  inline void fillRows(int handle, CategoryMask mask, const std::vector<double> &valuesX, const std::vector<double> &weights) {
+    main_.fillRows(handle,mask,valuesX,weights);
   }
 
   inline void fill(TString title, double value, double weight,std::vector<TString> cats){
@@ -31,27 +222,12 @@ class HistTool {
   }
 
   inline void fill(TString title, double value, double weight,TString cat="") {
-
-    if (not allPlots_.count(title)) {
+    int h(getHandle(title));
+    if (h<0) {
       //std::cout << "Histogram " << title << " not registered, not filling." << std::endl;
       return;
     }
-
-    if(allPlots_[title]->InheritsFrom("TH2")) return;
-    
-    //category specific plot, init if needed
-    if(cat!=""){
-      TString newTitle=cat+"_"+title;
-      if(not allPlots_.count(newTitle)) {
-        //std::cout << "Histogram " << title << " for cat=" << cat << " not yet started, adding now." << std::endl;
-        allPlots_[newTitle]=(TH1 *)allPlots_[title]->Clone(newTitle);
-        allPlots_[newTitle]->SetDirectory(0);
-        allPlots_[newTitle]->Reset("ICE");
-      }
-      title=newTitle;
-    }
-    
-    allPlots_[title]->Fill(value, weight);
+    fill(h,categoryMask(cat),value,weight);
   }
 
   inline void fill2D(TString title, double valueX, double valueY, double weight,std::vector<TString> cats){
@@ -60,33 +236,308 @@ class HistTool {
   }
 
   inline void fill2D(TString title, double valueX, double valueY, double weight,TString cat="") {
-    if (not all2dPlots_.count(title)) {
+    int h(getHandle(title));
+    if (h<0 || !is2D_[h]) {
       std::cout << "Histogram " << title << " not registered, not filling." << std::endl;
       return;
     }
-    
-    //category specific plot, init if needed
-    if(cat!=""){
-      TString newTitle=cat+"_"+title;
-      if(not all2dPlots_.count(newTitle)) {
-        //std::cout << "Histogram " << title << " for cat=" << cat << " not yet started, adding now." << std::endl;
-        all2dPlots_[newTitle]=(TH2 *)all2dPlots_[title]->Clone(newTitle);
-        all2dPlots_[newTitle]->SetDirectory(0);
-        all2dPlots_[newTitle]->Reset("ICE");
+    fill2D(h,categoryMask(cat),valueX,valueY,weight);
+  }
+
+  /**
+     @short one empty shard per worker, sharing the handle and category space of this tool
+   */
+  std::vector<HistShard> makeShards(size_t n) const {
+    for(size_t h=0; h<titles_.size(); h++) isDense(h);
+    return std::vector<HistShard>(n,HistShard(this));
+  }
+
+  /**
+     @short reduces the shards pairwise (in parallel within each step) into the first one
+     the pairing only depends on the number of shards, so the result is deterministic
+   */
+  static void reduce(std::vector<HistShard> &shards) {
+    for(size_t step=1; step<shards.size(); step*=2) {
+      std::vector<std::thread> workers;
+      for(size_t i=0; i+step<shards.size(); i+=2*step)
+        workers.push_back(std::thread([&shards,i,step](){ shards[i].add(shards[i+step]); shards[i+step].clear(); }));
+      for(auto &w : workers) w.join();
+    }
+  }
+
+  /**
+     @short adds the contents of the shards to this tool and empties them (call when the workers are idle,
+     e.g. at the end of the job or periodically for monitoring)
+   */
+  void merge(std::vector<HistShard> &shards) {
+    if(shards.empty()) return;
+    reduce(shards);
+    main_.add(shards[0]);
+    shards[0].clear();
+  }
+
+  /**
+     @short exchanges the contents filled so far with those of a shard of this tool,
+     e.g. with an empty one to run a pass whose fills are discarded, and back
+   */
+  void swapContents(HistShard &shard) { std::swap(main_,shard); }
+
+  /**
+     @short copies the contents filled so far to the registered histograms and their category clones
+   */
+  inline void sync() {
+    diagnostics().report("[HistTool] fills dropped for categories beyond the maximum",OVERFLOWCATEGORY,main_.nDropped_);
+    main_.nDropped_=0;
+    for(auto &it : main_.denseSlots_) {
+      TH1 *h=slot(it.first);
+      h->Reset("ICE");
+      it.second.fillInto(h);
+    }
+    for(auto &r : main_.replay_) {
+      int handle(r.slot/MAXCATEGORIES);
+      if(is2D_[handle]) ((TH2 *)slot(r.slot))->Fill(r.x,r.y,r.w);
+      else              slot(r.slot)->Fill(r.x,r.w);
+    }
+    main_.replay_.clear();
+  }
+
+  std::map<TString, TH1 *> &getPlots()   { sync(); return allPlots_; }
+  std::map<TString, TH2 *> &get2dPlots() { sync(); return all2dPlots_; }
+
+  /**
+     @short writes the non-empty histograms to dir (in the order of getPlots, then get2dPlots) and empties the tool
+     Each slot is converted, written and released in turn: the category clones are deleted once written,
+     so that at most one of them exists at a time. The registered histograms keep their contents
+     and those written are attached to dir, as they were when written from getPlots.
+   */
+  void write(TDirectory *dir) {
+    diagnostics().report("[HistTool] fills dropped for categories beyond the maximum",OVERFLOWCATEGORY,main_.nDropped_);
+    main_.nDropped_=0;
+
+    //replayed fills grouped by slot, in the order they were made
+    std::vector<HistShard::Replay_t> &replay=main_.replay_;
+    std::stable_sort(replay.begin(),replay.end(),[](const HistShard::Replay_t &a,const HistShard::Replay_t &b){ return a.slot<b.slot; });
+    std::vector<bool> replayed(slots_.size(),false);
+    for(auto &r : replay) replayed[r.slot]=true;
+
+    std::map<TString, int> slots1D, slots2D;
+    for(size_t islot=0; islot<slots_.size(); islot++) {
+      if(!slots_[islot] && main_.denseIdx_[islot]<0 && !replayed[islot]) continue;
+      int handle(islot/MAXCATEGORIES), cat(islot%MAXCATEGORIES);
+      TString name(cat==0 ? titles_[handle] : catNames_[cat]+"_"+titles_[handle]);
+      if(is2D_[handle]) slots2D[name]=islot;
+      else              slots1D[name]=islot;
+    }
+
+    for(auto *slotsByName : {&slots1D,&slots2D}) {
+      for(auto &it : *slotsByName) {
+        int islot(it.second), handle(islot/MAXCATEGORIES);
+        TH1 *h=slot(islot);
+        int idx(main_.denseIdx_[islot]);
+        if(idx>=0) {
+          h->Reset("ICE");
+          main_.denseSlots_[idx].second.fillInto(h);
+          main_.denseSlots_[idx].second=DenseHist();
+        }
+        auto r=std::lower_bound(replay.begin(),replay.end(),islot,[](const HistShard::Replay_t &a,int s){ return a.slot<s; });
+        for(; r!=replay.end() && r->slot==islot; r++) {
+          if(is2D_[handle]) ((TH2 *)h)->Fill(r->x,r->y,r->w);
+          else              h->Fill(r->x,r->w);
+        }
+        bool registered(islot%MAXCATEGORIES==0);
+        if(h->GetEntries()>0) {
+          if(registered) h->SetDirectory(dir);
+          dir->WriteTObject(h);
+        }
+        if(registered) continue;
+        if(is2D_[handle]) all2dPlots_.erase(it.first);
+        else              allPlots_.erase(it.first);
+        delete h;
+        slots_[islot]=0;
+      }
+    }
+    main_.clear();
+  }
+
+  /**
+     @short summary of the memory used by the histogram contents filled in the loop and by the histograms
+     they are converted to: those allocated so far, and the largest category clone which write will add
+   */
+  void printMemoryReport(std::ostream &out=std::cout, size_t nTop=5) const {
+    size_t total(main_.memoryBytes()), nSparse(0);
+    std::vector<size_t> perHandle(titles_.size(),0), perHandleCopies(titles_.size(),0);
+    for(auto &it : main_.denseSlots_) {
+      size_t bytes(it.second.memoryBytes());
+      nSparse += it.second.isSparse();
+      perHandle[it.first/MAXCATEGORIES] += bytes;
+      perHandleCopies[it.first/MAXCATEGORIES]++;
+    }
+    size_t nHists(0), histsTotal(0), maxClone(0);
+    for(size_t islot=0; islot<slots_.size(); islot++) {
+      int handle(islot/MAXCATEGORIES);
+      if(slots_[islot]) {
+        size_t bytes(histBytes(slots_[islot],isFloat_[handle],slots_[islot]->GetSumw2N()>0));
+        nHists++;
+        histsTotal += bytes;
+        perHandle[handle] += bytes;
+      }
+      else if(main_.denseIdx_[islot]>=0) {
+        const DenseHist &d=main_.denseSlots_[main_.denseIdx_[islot]].second;
+        maxClone=std::max(maxClone,histBytes(slots_[handle*MAXCATEGORIES],isFloat_[handle],d.isWeighted()));
       }
-      title=newTitle;
     }
-    
-    all2dPlots_[title]->Fill(valueX,valueY, weight);
+    for(auto &r : main_.replay_)
+      if(!slots_[r.slot]) maxClone=std::max(maxClone,histBytes(slots_[r.slot/MAXCATEGORIES*MAXCATEGORIES],isFloat_[r.slot/MAXCATEGORIES],true));
+    out << "[HistTool] " << main_.denseSlots_.size() << " histograms filled (" << nSparse << " sparse) in "
+        << catNames_.size()-1 << " categories, " << total/1024. << " kB" << std::endl;
+    out << "[HistTool] " << nHists << " histograms allocated, " << histsTotal/1024. << " kB, "
+        << "write adds one category clone at a time, at most " << maxClone/1024. << " kB" << std::endl;
+    std::vector<size_t> order(titles_.size());
+    for(size_t i=0; i<order.size(); i++) order[i]=i;
+    std::sort(order.begin(),order.end(),[&perHandle](size_t a,size_t b){ return perHandle[a]>perHandle[b]; });
+    for(size_t i=0; i<std::min(nTop,order.size()); i++) {
+      if(perHandle[order[i]]==0) break;
+      out << "\t" << titles_[order[i]] << ": " << perHandleCopies[order[i]] << " copies, " << perHandle[order[i]]/1024. << " kB" << std::endl;
+    }
   }
-  
-  std::map<TString, TH1 *> &getPlots()   { return allPlots_; }
-  std::map<TString, TH2 *> &get2dPlots() { return all2dPlots_; }
-  
+
  private:
+
+  friend class HistShard;
+
+  //storage of a histogram, decided at its first fill so that the axes (e.g. bin labels) can still be changed after addHist
+  inline bool isDense(int handle) const {
+    signed char &dense=isDense_[handle];
+    if(dense<0) dense=DenseHist::isSupported(slots_[handle*MAXCATEGORIES]);
+    return dense;
+  }
+
+  //approximate memory of the bin contents and errors of a histogram
+  static size_t histBytes(const TH1 *h, bool isFloat, bool hasSumw2) {
+    return h->GetNcells()*((isFloat ? sizeof(float) : sizeof(double)) + (hasSumw2 ? sizeof(double) : 0));
+  }
+
+  //registered histogram (category 0) or category specific copy, started if needed
+  inline TH1 *slot(int islot) {
+    TH1 *&h=slots_[islot];
+    if(h) return h;
+
+    int handle(islot/MAXCATEGORIES), cat(islot%MAXCATEGORIES);
+    //std::cout << "Histogram " << titles_[handle] << " for cat=" << catNames_[cat] << " not yet started, adding now." << std::endl;
+    TString newTitle=catNames_[cat]+"_"+titles_[handle];
+    h=(TH1 *)slots_[handle*MAXCATEGORIES]->Clone(newTitle);
+    h->SetDirectory(0);
+    h->Reset("ICE");
+    if(is2D_[handle]) all2dPlots_[newTitle]=(TH2 *)h;
+    else              allPlots_[newTitle]=h;
+    return h;
+  }
+
   std::map<TString, TH1 *> allPlots_;
   std::map<TString, TH2 *> all2dPlots_;
 
+  std::map<TString, int> handles_, categories_;
+  std::vector<TString> titles_, catNames_;
+  std::vector<bool> is2D_, isFloat_;
+  mutable std::vector<signed char> isDense_;          //[handle], -1 until the first fill (or makeShards)
+  std::vector<CategoryMask> allowed_;                 //[handle], categories filled
+  std::map<int, std::vector<TString> > allowLists_;   //handle -> allowed category names
+  size_t sparseThreshold_;
+  std::vector<TH1 *> slots_;   //[handle*MAXCATEGORIES+category]
+  HistShard main_;
 };
 
+inline HistShard::HistShard(const HistTool *tool) : tool_(tool), nDropped_(0)
+{
+  denseIdx_.resize(tool->slots_.size(),-1);
+}
+
+inline DenseHist &HistShard::denseSlot(int slot)
+{
+  int &idx=denseIdx_[slot];
+  if(idx<0) {
+    idx=denseSlots_.size();
+    int handle(slot/HistTool::MAXCATEGORIES);
+    const TH1 *proto=tool_->slots_[handle*HistTool::MAXCATEGORIES];
+    bool sparse(tool_->sparseThreshold_>0 && proto->GetDimension()==2 && size_t(proto->GetNcells())>tool_->sparseThreshold_);
+    denseSlots_.push_back(std::pair<int,DenseHist>(slot,DenseHist(proto,tool_->isFloat_[handle],sparse)));
+  }
+  return denseSlots_[idx].second;
+}
+
+inline void HistShard::fill(int handle, CategoryMask mask, double value, double weight)
+{
+  if(handle<0 || tool_->is2D_[handle]) return;
+  if(mask & HistTool::overflowMask()) nDropped_++;
+  mask &= tool_->allowed_[handle];
+  bool isDense(tool_->isDense(handle));
+  while(mask) {
+    int slot(handle*HistTool::MAXCATEGORIES+__builtin_ctzll(mask));
+    mask &= mask-1;
+    if(isDense) denseSlot(slot).fill(value,weight);
+    else        replay_.push_back(Replay_t{slot,value,0.,weight});
+  }
+}
+
+inline void HistShard::fill2D(int handle, CategoryMask mask, double valueX, double valueY, double weight)
+{
+  if(handle<0 || !tool_->is2D_[handle]) return;
+  if(mask & HistTool::overflowMask()) nDropped_++;
+  mask &= tool_->allowed_[handle];
+  bool isDense(tool_->isDense(handle));
+  while(mask) {
+    int slot(handle*HistTool::MAXCATEGORIES+__builtin_ctzll(mask));
+    mask &= mask-1;
+    if(isDense) denseSlot(slot).fill(valueX,valueY,weight);
+    else        replay_.push_back(Replay_t{slot,valueX,valueY,weight});
+  }
+}
+
+inline void HistShard::fillRows(int handle, CategoryMask mask, const std::vector<double> &valuesX, const std::vector<double> &weights)
+{
+  if(handle<0 || !tool_->is2D_[handle] || valuesX.empty()) return;
+  if(mask & HistTool::overflowMask()) nDropped_++;
+  mask &= tool_->allowed_[handle];
+  bool isDense(tool_->isDense(handle));
+  while(mask) {
+    int slot(handle*HistTool::MAXCATEGORIES+__builtin_ctzll(mask));
+    mask &= mask-1;
+    if(isDense) {
+      denseSlot(slot).fillRows(valuesX,weights);
+      continue;
+    }
+    for(size_t i=0; i<weights.size(); i++)
+      for(auto x : valuesX) replay_.push_back(Replay_t{slot,x,double(i),weights[i]});
+  }
+}
+
+inline void HistShard::add(const HistShard &other)
+{
+  for(auto &it : other.denseSlots_) {
+    int &idx=denseIdx_[it.first];
+    if(idx<0) {
+      idx=denseSlots_.size();
+      denseSlots_.push_back(it);
+    }
+    else denseSlots_[idx].second.add(it.second);
+  }
+  replay_.insert(replay_.end(),other.replay_.begin(),other.replay_.end());
+  nDropped_ += other.nDropped_;
+}
+
+inline size_t HistShard::memoryBytes() const
+{
+  size_t bytes(denseIdx_.capacity()*sizeof(int)+replay_.capacity()*sizeof(Replay_t));
+  for(auto &it : denseSlots_) bytes += it.second.memoryBytes();
+  return bytes;
+}
+
+inline void HistShard::clear()
+{
+  std::fill(denseIdx_.begin(),denseIdx_.end(),-1);
+  denseSlots_.clear();
+  replay_.clear();
+  nDropped_=0;
+}
+
 #endif
@@ -0,0 +1,100 @@
+#ifndef JetCalibrationCache_h
+#define JetCalibrationCache_h
+
+#include <cstddef>
+#include <vector>
+
+/**
+   @short per-event cache of the jet calibration results, stored as a structure of arrays
+
+   Each selected jet is added once with its raw and corrected pt; the uncertainties,
+   resolution smearing factors, quenching losses and modified b-tag decisions are then set
+   per jet. finalize() derives the varied pt and b-tag decision of every jet for all the
+   registered variations, so that any systematic counter is a single comparison per jet.
+ */
+class JetCalibrationCache
+{
+
+ public:
+
+  enum Variation { NOMINAL=0, JECUP, JECDN, JERUP, JERDN, BUP, BDN, UDSGUP, UDSGDN, QUENCHUP, QUENCHDN, NVARIATIONS };
+
+  JetCalibrationCache() { }
+
+  void clear()
+  {
+    rawpt.clear(); pt.clear(); eta.clear(); phi.clear();
+    jecUp.clear(); jecDn.clear(); jerSF.clear(); quenchLoss.clear();
+    btag.clear(); btagUp.clear(); btagDn.clear(); isB.clear();
+    for(size_t v=0; v<NVARIATIONS; v++) { varPt_[v].clear(); varBtag_[v].clear(); }
+  }
+
+  size_t size() const { return pt.size(); }
+
+  /**
+     @short adds a jet with neutral variations (no uncertainty, no smearing, no loss, unchanged b-tag)
+   */
+  size_t add(float _rawpt, float _pt, float _eta, float _phi, bool _btag, bool _isB=false)
+  {
+    rawpt.push_back(_rawpt); pt.push_back(_pt); eta.push_back(_eta); phi.push_back(_phi);
+    jecUp.push_back(0.); jecDn.push_back(0.); jerSF.push_back(1.); quenchLoss.push_back(0.);
+    btag.push_back(_btag); btagUp.push_back(_btag); btagDn.push_back(_btag); isB.push_back(_isB);
+    return pt.size()-1;
+  }
+
+  /**
+     @short derives the varied pt and b-tag decision per jet for all variations
+   */
+  void finalize()
+  {
+    size_t n(size());
+    for(size_t v=0; v<NVARIATIONS; v++) { varPt_[v].resize(n); varBtag_[v].resize(n); }
+    for(size_t i=0; i<n; i++) {
+
+      //the JEC uncertainty shifts the threshold, which is equivalent to scaling down the pt
+      varPt_[NOMINAL][i]  = pt[i];
+      varPt_[JECUP][i]    = pt[i]/(1+jecUp[i]);
+      varPt_[JECDN][i]    = pt[i]/(1-jecDn[i]);
+      varPt_[JERUP][i]    = pt[i]*jerSF[i];
+      varPt_[JERDN][i]    = pt[i]/jerSF[i];
+      varPt_[BUP][i]      = pt[i];
+      varPt_[BDN][i]      = pt[i];
+      varPt_[UDSGUP][i]   = pt[i];
+      varPt_[UDSGDN][i]   = pt[i];
+      varPt_[QUENCHUP][i] = pt[i];
+      varPt_[QUENCHDN][i] = pt[i]-quenchLoss[i];
+
+      //b-tag variations act only on the b or on the udsg jets
+      for(size_t v=0; v<NVARIATIONS; v++) varBtag_[v][i]=btag[i];
+      varBtag_[ isB[i] ? BUP : UDSGUP ][i] = btagUp[i];
+      varBtag_[ isB[i] ? BDN : UDSGDN ][i] = btagDn[i];
+    }
+  }
+
+  /**
+     @short number of b-tagged jets above threshold for a given variation (call finalize() first)
+   */
+  int countBJets(Variation v, float minPt) const
+  {
+    const std::vector<float> &vpt=varPt_[v];
+    const std::vector<char> &vtag=varBtag_[v];
+    int n(0);
+    for(size_t i=0; i<vpt.size(); i++) n += (vpt[i]>minPt && vtag[i]);
+    return n;
+  }
+
+  const std::vector<float> &variedPt(Variation v) const { return varPt_[v]; }
+  const std::vector<char> &variedBtag(Variation v) const { return varBtag_[v]; }
+
+  //calibration results per jet
+  std::vector<float> rawpt, pt, eta, phi;
+  std::vector<float> jecUp, jecDn, jerSF, quenchLoss;
+  std::vector<char> btag, btagUp, btagDn, isB;
+
+ private:
+
+  std::vector<float> varPt_[NVARIATIONS];
+  std::vector<char> varBtag_[NVARIATIONS];
+};
+
+#endif
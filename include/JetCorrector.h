@@ -6,10 +6,14 @@
 // Supposedly runs faster than v1.0
 // v3.0: one can add list of text files to apply them one by one
 
+#ifndef JetCorrector_h
+#define JetCorrector_h
+
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <sstream>
+#include <algorithm>
 
 #include "TF1.h"
 #include "TF2.h"
@@ -36,6 +40,11 @@ public:
    void SetRho(double value)       { Rho = value; }
    double GetCorrection();
    double GetCorrectedPT();
+   double GetCorrectedPT(int NLevels);
+   int GetNLevels()                { return JEC.size(); }
+   std::vector<double> GetEtaBinEdges();
+   std::vector<double> GetPTBinEdges(double Eta);
+   std::vector<double> GetPTKinks(int Level, double Eta);
 };
 
 class SingleJetCorrector
@@ -69,7 +78,11 @@ public:
    double GetCorrection();
    double GetCorrectedPT();
    double GetValue(Type T);
+   std::vector<double> GetEtaBinEdges();
+   std::vector<double> GetPTBinEdges(double Eta);
+   std::vector<double> GetPTKinks(double Eta);
 private:
+   std::vector<double> GetBinEdges(Type T, double Eta, bool RequireEta);
    std::string Hack4(std::string Formula, char V, int N);
 };
    
@@ -90,9 +103,15 @@ double JetCorrector::GetCorrection()
 
 double JetCorrector::GetCorrectedPT()
 {
+   return GetCorrectedPT(JEC.size());
+}
+
+double JetCorrector::GetCorrectedPT(int NLevels)
+{
+   // pt after the first NLevels levels
    double PT = JetPT;
 
-   for(int i = 0; i < (int)JEC.size(); i++)  
+   for(int i = 0; i < (int)JEC.size() && i < NLevels; i++)  
    {
       JEC[i].SetJetPT(PT);
       JEC[i].SetJetEta(JetEta);
@@ -109,6 +128,36 @@ double JetCorrector::GetCorrectedPT()
    return PT;
 }
 
+std::vector<double> JetCorrector::GetEtaBinEdges()
+{
+   // union of the eta bin edges of all levels
+   std::vector<double> Edges;
+   for(int i = 0; i < (int)JEC.size(); i++)
+   {
+      std::vector<double> E = JEC[i].GetEtaBinEdges();
+      Edges.insert(Edges.end(), E.begin(), E.end());
+   }
+   std::sort(Edges.begin(), Edges.end());
+   Edges.erase(std::unique(Edges.begin(), Edges.end()), Edges.end());
+   return Edges;
+}
+
+std::vector<double> JetCorrector::GetPTBinEdges(double Eta)
+{
+   // only the first level is binned in raw pt, the others see the corrected pt
+   if(JEC.size() == 0)
+      return std::vector<double>();
+   return JEC[0].GetPTBinEdges(Eta);
+}
+
+std::vector<double> JetCorrector::GetPTKinks(int Level, double Eta)
+{
+   // in the pt seen by this level, i.e. corrected by the previous levels
+   if(Level < 0 || Level >= (int)JEC.size())
+      return std::vector<double>();
+   return JEC[Level].GetPTKinks(Eta);
+}
+
 void SingleJetCorrector::Initialize(std::string FileName)
 {
    int nvar = 0, npar = 0;
@@ -365,6 +414,83 @@ double SingleJetCorrector::GetValue(Type T)
    return -1;
 }
 
+std::vector<double> SingleJetCorrector::GetEtaBinEdges()
+{
+   return GetBinEdges(TypeJetEta, 0, false);
+}
+
+std::vector<double> SingleJetCorrector::GetPTBinEdges(double Eta)
+{
+   return GetBinEdges(TypeJetPT, Eta, true);
+}
+
+std::vector<double> SingleJetCorrector::GetPTKinks(double Eta)
+{
+   // pt bin edges and limits of the pt parameter range, where the correction is not smooth
+   std::vector<double> Kinks = GetPTBinEdges(Eta);
+
+   for(int iE = 0; iE < (int)BinTypes.size(); iE++)
+   {
+      bool InBin = true;
+      for(int iB = 0; iB < (int)BinTypes[iE].size(); iB++)
+      {
+         if(BinTypes[iE][iB] != TypeJetEta)
+            continue;
+         if(Eta < BinRanges[iE][iB*2] || Eta > BinRanges[iE][iB*2+1])
+            InBin = false;
+      }
+      if(InBin == false)
+         continue;
+
+      // only the first three parameters are clamped in GetCorrection
+      for(int i = 0; i < 3 && i < (int)Dependencies[iE].size(); i++)
+      {
+         if(Dependencies[iE][i] != TypeJetPT)
+            continue;
+         Kinks.push_back(DependencyRanges[iE][i*2]);
+         Kinks.push_back(DependencyRanges[iE][i*2+1]);
+      }
+   }
+
+   std::sort(Kinks.begin(), Kinks.end());
+   Kinks.erase(std::unique(Kinks.begin(), Kinks.end()), Kinks.end());
+   return Kinks;
+}
+
+std::vector<double> SingleJetCorrector::GetBinEdges(Type T, double Eta, bool RequireEta)
+{
+   std::vector<double> Edges;
+
+   for(int iE = 0; iE < (int)BinTypes.size(); iE++)
+   {
+      bool InBin = true;
+      if(RequireEta == true)
+      {
+         for(int iB = 0; iB < (int)BinTypes[iE].size(); iB++)
+         {
+            if(BinTypes[iE][iB] != TypeJetEta)
+               continue;
+            if(Eta < BinRanges[iE][iB*2] || Eta > BinRanges[iE][iB*2+1])
+               InBin = false;
+         }
+      }
+      if(InBin == false)
+         continue;
+
+      for(int iB = 0; iB < (int)BinTypes[iE].size(); iB++)
+      {
+         if(BinTypes[iE][iB] != T)
+            continue;
+         Edges.push_back(BinRanges[iE][iB*2]);
+         Edges.push_back(BinRanges[iE][iB*2+1]);
+      }
+   }
+
+   std::sort(Edges.begin(), Edges.end());
+   Edges.erase(std::unique(Edges.begin(), Edges.end()), Edges.end());
+   return Edges;
+}
+
 std::string SingleJetCorrector::Hack4(std::string Formula, char V, int N)
 {
    int Size = Formula.size();
@@ -385,3 +511,4 @@ std::string SingleJetCorrector::Hack4(std::string Formula, char V, int N)
    return Formula;
 }
 
+#endif
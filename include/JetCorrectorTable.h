@@ -0,0 +1,243 @@
+#ifndef JetCorrectorTable_h
+#define JetCorrectorTable_h
+
+#include "HeavyIonsAnalysis/topskim/include/JetCorrector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/**
+   @short tabulated version of a JetCorrector chain
+
+   The full chain of corrections is sampled once at load time on a (log pt, eta) grid
+   and evaluated afterwards by bilinear interpolation of the correction factor.
+   The grid follows the eta bins of all levels and, in pt, the kinks of all levels: the pt bin edges
+   and the limits of the pt parameter range, beyond which the formulas are clamped. The kinks of the
+   later levels are in corrected pt and are mapped to raw pt through the previous levels at both ends
+   of each eta segment, as they move with eta.
+   Eta segments where the correction depends on phi (e.g. the HEM15/16 term) are
+   flagged at build time and always evaluated with the exact chain.
+   The table is refused if the maximum relative deviation from the exact chain exceeds the requested
+   tolerance. It is probed on a sub-grid of every cell and next to the raw pt of the kinks at each
+   probed eta, where the interpolation error of a kink inside a cell is the largest.
+   Kinks which are not parameter limits (e.g. a max() in the formula) are not located and only
+   seen through the sub-grid.
+ */
+class JetCorrectorTable
+{
+
+ public:
+
+  JetCorrectorTable(JetCorrector &jec) : jec_(&jec), valid_(false), maxRelDev_(-1), nPt_(0), nEta_(0) { }
+
+  /**
+     @short samples the chain in [etaMin,etaMax]x[ptMin,ptMax] with nPt (nEta) nodes per pt (eta) segment
+     returns false if the interpolation error exceeds the tolerance, in which case the exact chain is used
+   */
+  bool build(double tolerance=1e-4,
+             double etaMin=-2.5, double etaMax=2.5, double ptMin=5., double ptMax=1000.,
+             int nPt=16, int nEta=2)
+  {
+    valid_=false;
+    maxRelDev_=-1;
+    nPt_=std::max(nPt,2);
+    nEta_=std::max(nEta,2);
+    etaEdges_.clear(); phiDependent_.clear();
+    ptEdgeBegin_.clear(); ptEdgeEnd_.clear();
+    logPtEdges_.clear(); nodeOffset_.clear(); corr_.clear();
+
+    //eta segments: all the eta bin edges of the chain inside the requested range
+    etaEdges_.push_back(etaMin);
+    for(auto e : jec_->GetEtaBinEdges())
+      if(e>etaMin && e<etaMax) etaEdges_.push_back(e);
+    etaEdges_.push_back(etaMax);
+
+    double logPtMin(log(ptMin)), logPtMax(log(ptMax));
+    for(size_t s=0; s+1<etaEdges_.size(); s++) {
+
+      double etaLo(etaEdges_[s]), etaHi(etaEdges_[s+1]);
+
+      //pt segments: the kinks of all levels in raw pt, at both ends of the eta segment
+      std::vector<double> lpEdges={logPtMin,logPtMax};
+      for(int j : {0,nEta_-1})
+        for(auto pt : rawPTKinks(nodeValue(etaLo,etaHi,j,nEta_,1e-5),ptMin,ptMax))
+          lpEdges.push_back(log(pt));
+      std::sort(lpEdges.begin(),lpEdges.end());
+      ptEdgeBegin_.push_back(logPtEdges_.size());
+      for(auto lp : lpEdges)
+        if(logPtEdges_.size()==ptEdgeBegin_.back() || lp-logPtEdges_.back()>1e-5) logPtEdges_.push_back(lp);
+      logPtEdges_.back()=logPtMax;
+      ptEdgeEnd_.push_back(logPtEdges_.size());
+
+      //sample the nodes of each cell block
+      bool phiDep(false);
+      for(size_t k=ptEdgeBegin_[s]; k+1<ptEdgeEnd_[s]; k++) {
+        nodeOffset_.push_back(corr_.size());
+        double lpLo(logPtEdges_[k]), lpHi(logPtEdges_[k+1]);
+        for(int j=0; j<nEta_; j++) {
+          double eta=nodeValue(etaLo,etaHi,j,nEta_,1e-5);
+          for(int i=0; i<nPt_; i++)
+            corr_.push_back( exactCorrection(exp(nodeValue(lpLo,lpHi,i,nPt_,1e-7)),eta,0.) );
+        }
+
+        //check if phi enters the correction in this segment
+        double ptMid(exp(0.5*(lpLo+lpHi))),etaMid(0.5*(etaLo+etaHi));
+        double ref(exactCorrection(ptMid,etaMid,0.));
+        for(int iphi=0; iphi<24 && !phiDep; iphi++) {
+          double phi(-M_PI+(iphi+0.5)*2*M_PI/24.);
+          if(fabs(exactCorrection(ptMid,etaMid,phi)-ref)>tolerance*fabs(ref)) phiDep=true;
+        }
+      }
+      phiDependent_.push_back(phiDep);
+    }
+
+    //probe the interpolation error on a sub-grid of each cell and on both sides of the kinks
+    const int nSub(5);
+    maxRelDev_=0.;
+    size_t nPhiDep(0);
+    for(size_t s=0; s+1<etaEdges_.size(); s++) {
+      if(phiDependent_[s]) { nPhiDep++; continue; }
+      double etaLo(etaEdges_[s]), etaHi(etaEdges_[s+1]);
+      for(int j=0; j+1<nEta_; j++) {
+        for(int js=0; js<nSub; js++) {
+          double etaNodeLo(nodeValue(etaLo,etaHi,j,nEta_)), etaNodeHi(nodeValue(etaLo,etaHi,j+1,nEta_));
+          double eta=etaNodeLo+(js+0.5)/nSub*(etaNodeHi-etaNodeLo);
+          std::vector<double> probes;
+          for(size_t k=ptEdgeBegin_[s]; k+1<ptEdgeEnd_[s]; k++) {
+            double lpLo(logPtEdges_[k]), lpHi(logPtEdges_[k+1]);
+            for(int i=0; i+1<nPt_; i++) {
+              double lpNodeLo(nodeValue(lpLo,lpHi,i,nPt_)), lpNodeHi(nodeValue(lpLo,lpHi,i+1,nPt_));
+              for(int is=0; is<nSub; is++) probes.push_back(exp(lpNodeLo+(is+0.5)/nSub*(lpNodeHi-lpNodeLo)));
+            }
+          }
+          for(auto pt : rawPTKinks(eta,ptMin,ptMax)) {
+            probes.push_back(pt*(1-1e-6));
+            probes.push_back(pt*(1+1e-6));
+          }
+          for(auto pt : probes) {
+            double exact(exactCorrection(pt,eta,0.));
+            double interp(interpolate(s,pt,eta));
+            if(exact<=0 || interp<=0) continue;
+            maxRelDev_=std::max(maxRelDev_,fabs(interp-exact)/exact);
+          }
+        }
+      }
+    }
+
+    valid_=(maxRelDev_<=tolerance);
+    std::cout << "[JetCorrectorTable] " << corr_.size() << " nodes in " << etaEdges_.size()-1 << " eta segments"
+              << " (" << nPhiDep << " phi-dependent, kept exact)"
+              << ", max. relative deviation " << maxRelDev_ << " for tolerance " << tolerance
+              << (valid_ ? "" : " => table refused, using exact corrections") << std::endl;
+    return valid_;
+  }
+
+  bool isValid() const { return valid_; }
+  double maxRelDeviation() const { return maxRelDev_; }
+
+  /**
+     @short returns the corrected pt: tabulated if possible, from the exact chain otherwise
+   */
+  double getCorrectedPT(double rawpt, double eta, double phi)
+  {
+    if(valid_ && rawpt>0) {
+      int s=findEtaSegment(eta);
+      if(s>=0 && !phiDependent_[s]) {
+        double corr=interpolate(s,rawpt,eta);
+        if(corr>0) return rawpt*corr;
+      }
+    }
+    jec_->SetJetPT(rawpt);
+    jec_->SetJetEta(eta);
+    jec_->SetJetPhi(phi);
+    return jec_->GetCorrectedPT();
+  }
+
+ private:
+
+  //position of the i-th node, nodes on the edges are moved by eps inside the segment
+  //as the bin edges in the text files are inclusive and the lower bin would be picked
+  static double nodeValue(double lo, double hi, int i, int n, double eps=0.)
+  {
+    double x(lo+(hi-lo)*i/double(n-1));
+    return std::min(std::max(x,lo+eps),hi-eps);
+  }
+
+  double exactCorrection(double pt, double eta, double phi)
+  {
+    jec_->SetJetPT(pt);
+    jec_->SetJetEta(eta);
+    jec_->SetJetPhi(phi);
+    return jec_->GetCorrection();
+  }
+
+  //raw pt of the kinks of all levels in ]ptMin,ptMax[, the kinks of a level are in the pt corrected by the previous ones
+  std::vector<double> rawPTKinks(double eta, double ptMin, double ptMax)
+  {
+    std::vector<double> kinks;
+    for(int l=0; l<jec_->GetNLevels(); l++) {
+      for(auto k : jec_->GetPTKinks(l,eta)) {
+        double pt(l==0 ? k : rawPT(l,k,eta,ptMin,ptMax));
+        if(pt>ptMin && pt<ptMax) kinks.push_back(pt);
+      }
+    }
+    return kinks;
+  }
+
+  //raw pt for which the first nLevels levels give the corrected pt, by bisection in log pt (-1 if not in [ptMin,ptMax])
+  double rawPT(int nLevels, double correctedPT, double eta, double ptMin, double ptMax)
+  {
+    auto partial=[&](double lp) {
+      jec_->SetJetPT(exp(lp));
+      jec_->SetJetEta(eta);
+      jec_->SetJetPhi(0.);
+      return jec_->GetCorrectedPT(nLevels);
+    };
+    double lo(log(ptMin)), hi(log(ptMax));
+    double ptLo(partial(lo)), ptHi(partial(hi));
+    if(ptLo<0 || ptHi<0 || correctedPT<ptLo || correctedPT>ptHi) return -1;
+    for(int it=0; it<60; it++) {
+      double mid(0.5*(lo+hi));
+      if(partial(mid)<correctedPT) lo=mid;
+      else                         hi=mid;
+    }
+    return exp(0.5*(lo+hi));
+  }
+
+  int findEtaSegment(double eta) const
+  {
+    if(eta<etaEdges_.front() || eta>=etaEdges_.back()) return -1;
+    return int(std::upper_bound(etaEdges_.begin(),etaEdges_.end(),eta)-etaEdges_.begin())-1;
+  }
+
+  double interpolate(int s, double pt, double eta) const
+  {
+    double lp(log(pt));
+    const double *lpBegin(&logPtEdges_[ptEdgeBegin_[s]]), *lpEnd(&logPtEdges_[0]+ptEdgeEnd_[s]);
+    if(lp<*lpBegin || lp>=*(lpEnd-1)) return -1;
+    size_t k=std::upper_bound(lpBegin,lpEnd,lp)-lpBegin-1;
+
+    double u=(lp-lpBegin[k])/(lpBegin[k+1]-lpBegin[k])*(nPt_-1);
+    double v=(eta-etaEdges_[s])/(etaEdges_[s+1]-etaEdges_[s])*(nEta_-1);
+    int i=std::min(int(u),nPt_-2), j=std::min(int(v),nEta_-2);
+    u-=i; v-=j;
+
+    const double *c=&corr_[nodeOffset_[ptEdgeBegin_[s]-s+k]+j*nPt_+i];
+    return (1-v)*((1-u)*c[0]+u*c[1]) + v*((1-u)*c[nPt_]+u*c[nPt_+1]);
+  }
+
+  JetCorrector *jec_;
+  bool valid_;
+  double maxRelDev_;
+  int nPt_, nEta_;
+  std::vector<double> etaEdges_;
+  std::vector<bool> phiDependent_;
+  std::vector<size_t> ptEdgeBegin_, ptEdgeEnd_;
+  std::vector<double> logPtEdges_;
+  std::vector<size_t> nodeOffset_;
+  std::vector<double> corr_;
+};
+
+#endif
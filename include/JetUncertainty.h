@@ -3,12 +3,18 @@
 // Author: Yi Chen
 // 
 // This class gives you jet uncertainties
+// v1.1: binary search over eta and PT bins, batch interface for all jets of an event
+// v1.2: can be initialized from a stream (e.g. one section of a sources file)
 //
 
+#ifndef JetUncertainty_h
+#define JetUncertainty_h
+
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <sstream>
+#include <algorithm>
 
 #include "TF1.h"
 #include "TF2.h"
@@ -25,9 +31,11 @@ private:
    std::vector<std::vector<double>> PTBins;
    std::vector<std::vector<double>> ErrorLow;
    std::vector<std::vector<double>> ErrorHigh;
+   bool EtaOnly;
+   std::vector<double> EtaLow, EtaHigh;
 public:
-   JetUncertainty()                  { Initialized = false; }
-   JetUncertainty(std::string File)  { Initialized = false; Initialize(File); }
+   JetUncertainty()                  { Initialized = false; EtaOnly = false; }
+   JetUncertainty(std::string File)  { Initialized = false; EtaOnly = false; Initialize(File); }
    ~JetUncertainty()                 {}
    void SetJetPT(double value)     { JetPT = value; }
    void SetJetEta(double value)    { JetEta = value; }
@@ -35,23 +43,38 @@ public:
    void SetJetArea(double value)   { JetArea = value; }
    void SetRho(double value)       { Rho = value; }
    void Initialize(std::string FileName);
+   void Initialize(std::istream &in);
+   bool IsEtaOnly()                                   { return EtaOnly; }
+   const std::vector<double> &GetEtaLow()             { return EtaLow; }
+   const std::vector<double> &GetEtaHigh()            { return EtaHigh; }
+   const std::vector<double> &GetPTNodes(int iE)      { return PTBins[iE]; }
    std::vector<std::string> BreakIntoParts(std::string Line);
    bool CheckDefinition(std::string Line);
    std::string StripBracket(std::string Line);
    JetUncertainty::Type ToType(std::string Line);
    std::pair<double, double> GetUncertainty();
+   std::pair<double, double> GetUncertainty(double PT, double Eta);
+   std::vector<std::pair<double, double>> GetUncertainties(const std::vector<double> &PT, const std::vector<double> &Eta);
    double GetValue(Type T);
+private:
+   int FindEntry();
+   std::pair<double, double> Interpolate(int iE, double PT);
 };
 
 void JetUncertainty::Initialize(std::string FileName)
+{
+   std::ifstream in(FileName.c_str());
+   Initialize(in);
+   in.close();
+}
+
+void JetUncertainty::Initialize(std::istream &in)
 {
    int nvar = 0, npar = 0;
    std::string CurrentFormula = "";
    std::vector<Type> CurrentDependencies;
    std::vector<Type> CurrentBinTypes;
 
-   std::ifstream in(FileName.c_str());
-
    while(in)
    {
       char ch[1048576];
@@ -121,7 +144,22 @@ void JetUncertainty::Initialize(std::string FileName)
       }
    }
 
-   in.close();
+   // if the file is binned only in eta with ordered, non-overlapping bins the entry can be found by binary search
+   EtaOnly = (BinTypes.size() > 0);
+   EtaLow.clear();
+   EtaHigh.clear();
+   for(int iE = 0; iE < (int)BinTypes.size() && EtaOnly == true; iE++)
+   {
+      if(BinTypes[iE].size() != 1 || BinTypes[iE][0] != TypeJetEta)
+         EtaOnly = false;
+      else if(iE > 0 && BinRanges[iE][0] < EtaHigh[iE-1])
+         EtaOnly = false;
+      else
+      {
+         EtaLow.push_back(BinRanges[iE][0]);
+         EtaHigh.push_back(BinRanges[iE][1]);
+      }
+   }
 
    Initialized = true;
 }
@@ -190,6 +228,42 @@ std::pair<double, double> JetUncertainty::GetUncertainty()
    if(Initialized == false)
       return std::pair<double, double>(-1, -1);
 
+   int iE = FindEntry();
+   if(iE < 0)
+      return std::pair<double, double>(-1, -1);
+
+   return Interpolate(iE, GetValue(TypeJetPT));
+}
+
+std::pair<double, double> JetUncertainty::GetUncertainty(double PT, double Eta)
+{
+   SetJetPT(PT);
+   SetJetEta(Eta);
+   return GetUncertainty();
+}
+
+std::vector<std::pair<double, double>> JetUncertainty::GetUncertainties(const std::vector<double> &PT, const std::vector<double> &Eta)
+{
+   std::vector<std::pair<double, double>> Result(PT.size(), std::pair<double, double>(-1, -1));
+
+   for(int i = 0; i < (int)PT.size() && i < (int)Eta.size(); i++)
+      Result[i] = GetUncertainty(PT[i], Eta[i]);
+
+   return Result;
+}
+
+int JetUncertainty::FindEntry()
+{
+   if(EtaOnly == true)
+   {
+      // first bin whose upper edge is not below eta, as for the linear scan (edges are inclusive)
+      double Eta = GetValue(TypeJetEta);
+      int iE = std::lower_bound(EtaHigh.begin(), EtaHigh.end(), Eta) - EtaHigh.begin();
+      if(iE >= (int)EtaLow.size() || Eta < EtaLow[iE])
+         return -1;
+      return iE;
+   }
+
    int N = BinTypes.size();
 
    for(int iE = 0; iE < N; iE++)
@@ -203,36 +277,34 @@ std::pair<double, double> JetUncertainty::GetUncertainty()
             InBin = false;
       }
 
-      if(InBin == false)
-         continue;
+      if(InBin == true)
+         return iE;
+   }
 
-      if(PTBins[iE].size() == 0)
-         return std::pair<double, double>(-1, -1);
+   return -1;
+}
 
-      double JetPT = GetValue(TypeJetPT);
+std::pair<double, double> JetUncertainty::Interpolate(int iE, double JetPT)
+{
+   const std::vector<double> &PT = PTBins[iE];
+   int N = PT.size();
 
-      if(JetPT < PTBins[iE][0])
-         return std::pair<double, double>(ErrorLow[iE][0], ErrorHigh[iE][0]);
-      if(JetPT >= PTBins[iE][PTBins[iE].size()-1])
-         return std::pair<double, double>(ErrorLow[iE][PTBins[iE].size()-1], ErrorHigh[iE][PTBins[iE].size()-1]);
-      
-      int Bin = 0;
-      for(int i = 0; i < (int)PTBins[iE].size() - 1; i++)
-      {
-         if(JetPT >= PTBins[iE][i] && JetPT < PTBins[iE][i+1])
-         {
-            Bin = i;
-            break;
-         }
-      }
+   if(N == 0)
+      return std::pair<double, double>(-1, -1);
 
-      double Low = ErrorLow[iE][Bin] + (ErrorLow[iE][Bin+1] - ErrorLow[iE][Bin]) / (PTBins[iE][Bin+1] - PTBins[iE][Bin]) * (JetPT - PTBins[iE][Bin]);
-      double High = ErrorHigh[iE][Bin] + (ErrorHigh[iE][Bin+1] - ErrorHigh[iE][Bin]) / (PTBins[iE][Bin+1] - PTBins[iE][Bin]) * (JetPT - PTBins[iE][Bin]);
+   if(JetPT < PT[0])
+      return std::pair<double, double>(ErrorLow[iE][0], ErrorHigh[iE][0]);
+   if(JetPT >= PT[N-1])
+      return std::pair<double, double>(ErrorLow[iE][N-1], ErrorHigh[iE][N-1]);
 
-      return std::pair<double, double>(Low, High);
-   }
+   // linear interpolation between the two surrounding pt nodes
+   int Bin = std::upper_bound(PT.begin(), PT.end(), JetPT) - PT.begin() - 1;
+   double Fraction = (JetPT - PT[Bin]) / (PT[Bin+1] - PT[Bin]);
 
-   return std::pair<double, double>(-1, -1);
+   double Low = ErrorLow[iE][Bin] + (ErrorLow[iE][Bin+1] - ErrorLow[iE][Bin]) * Fraction;
+   double High = ErrorHigh[iE][Bin] + (ErrorHigh[iE][Bin+1] - ErrorHigh[iE][Bin]) * Fraction;
+
+   return std::pair<double, double>(Low, High);
 }
 
 double JetUncertainty::GetValue(Type T)
@@ -247,4 +319,4 @@ double JetUncertainty::GetValue(Type T)
    return -1;
 }
 
-
+#endif
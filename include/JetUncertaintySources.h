@@ -0,0 +1,164 @@
+#ifndef JetUncertaintySources_h
+#define JetUncertaintySources_h
+
+#include "HeavyIonsAnalysis/topskim/include/JetUncertainty.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+   @short evaluates all the sources of a split JEC uncertainty file in a single lookup
+
+   The file is in the standard format with one [SourceName] section per source.
+   All the sources must share the (eta bin, pt node) grid of the first source, which is
+   checked at load time (the file is refused otherwise), and are stored such that the (up,down) values of all sources for a given
+   node are contiguous: a jet costs one binary search in eta, one in pt and a linear
+   interpolation over a contiguous block of 2*nSources values.
+ */
+class JetUncertaintySources
+{
+
+ public:
+
+  JetUncertaintySources() { }
+
+  /**
+     @short CTOR - parses all the sections of the file (or only the ones listed in keep)
+   */
+  JetUncertaintySources(std::string url, std::vector<std::string> keep=std::vector<std::string>())
+    {
+      initialize(url,keep);
+    }
+
+  void initialize(std::string url, std::vector<std::string> keep=std::vector<std::string>())
+  {
+    names_.clear(); etaLow_.clear(); etaHigh_.clear(); ptOffset_.clear(); ptNodes_.clear(); unc_.clear();
+
+    //split the file in sections
+    std::vector<std::string> sectionNames;
+    std::vector<std::string> sectionContents;
+    std::ifstream in(url.c_str());
+    std::string line;
+    while(std::getline(in,line)) {
+      size_t start=line.find_first_not_of(" \t");
+      if(start!=std::string::npos && line[start]=='[') {
+        size_t end=line.find(']',start);
+        sectionNames.push_back(line.substr(start+1,end==std::string::npos ? std::string::npos : end-start-1));
+        sectionContents.push_back("");
+        continue;
+      }
+      if(sectionContents.size()==0) {
+        //a file without sections is a single source, blank and comment lines before the first section are skipped
+        if(start==std::string::npos || line[start]=='#') continue;
+        sectionNames.push_back("Total");
+        sectionContents.push_back("");
+      }
+      sectionContents.back()+=line+"\n";
+    }
+    in.close();
+
+    std::vector<JetUncertainty> sources;
+    for(size_t i=0; i<sectionNames.size(); i++) {
+      if(keep.size() && std::find(keep.begin(),keep.end(),sectionNames[i])==keep.end()) continue;
+      std::istringstream sin(sectionContents[i]);
+      sources.push_back(JetUncertainty());
+      sources.back().Initialize(sin);
+      names_.push_back(sectionNames[i]);
+    }
+    if(sources.size()==0) {
+      std::cout << "[JetUncertaintySources] no sources found in " << url << std::endl;
+      return;
+    }
+    if(!sources[0].IsEtaOnly()) {
+      std::cout << "[JetUncertaintySources] " << url << " is not binned only in eta, can't build the common grid" << std::endl;
+      names_.clear();
+      return;
+    }
+    for(size_t isrc=1; isrc<sources.size(); isrc++) {
+      bool sameGrid(sources[isrc].IsEtaOnly()
+                    && sources[isrc].GetEtaLow()==sources[0].GetEtaLow()
+                    && sources[isrc].GetEtaHigh()==sources[0].GetEtaHigh());
+      for(size_t ieta=0; sameGrid && ieta<sources[0].GetEtaLow().size(); ieta++)
+        sameGrid = (sources[isrc].GetPTNodes(ieta)==sources[0].GetPTNodes(ieta));
+      if(sameGrid) continue;
+      std::cout << "[JetUncertaintySources] " << names_[isrc] << " is not binned as " << names_[0]
+                << " in " << url << ", can't build the common grid" << std::endl;
+      names_.clear();
+      return;
+    }
+
+    //common grid from the first source, all sources are evaluated at its nodes
+    size_t nsrc(sources.size());
+    etaLow_=sources[0].GetEtaLow();
+    etaHigh_=sources[0].GetEtaHigh();
+    for(size_t ieta=0; ieta<etaLow_.size(); ieta++) {
+      ptOffset_.push_back(ptNodes_.size());
+      const std::vector<double> &nodes=sources[0].GetPTNodes(ieta);
+      ptNodes_.insert(ptNodes_.end(),nodes.begin(),nodes.end());
+      double eta(0.5*(etaLow_[ieta]+etaHigh_[ieta]));
+      for(auto pt : nodes) {
+        for(size_t isrc=0; isrc<nsrc; isrc++) {
+          std::pair<double,double> u=sources[isrc].GetUncertainty(pt,eta);
+          unc_.push_back(u.first);
+          unc_.push_back(u.second);
+        }
+      }
+    }
+    ptOffset_.push_back(ptNodes_.size());
+    result_.resize(2*nsrc,0.);
+
+    std::cout << "[JetUncertaintySources] loaded " << nsrc << " sources from " << url << std::endl;
+  }
+
+  size_t size() const { return names_.size(); }
+  const std::vector<std::string> &names() const { return names_; }
+
+  /**
+     @short returns the (up,down) uncertainties of all sources interleaved: [2*isrc]=up, [2*isrc+1]=down
+     outside the eta range all uncertainties are set to 0
+   */
+  const std::vector<float> &eval(double pt, double eta)
+  {
+    size_t nval(result_.size());
+    std::fill(result_.begin(),result_.end(),0.);
+
+    //same conventions as JetUncertainty: inclusive eta edges, pt clamped to the first/last node
+    size_t ieta=std::lower_bound(etaHigh_.begin(),etaHigh_.end(),eta)-etaHigh_.begin();
+    if(ieta>=etaLow_.size() || eta<etaLow_[ieta]) return result_;
+
+    const double *nodes(&ptNodes_[0]+ptOffset_[ieta]);
+    size_t n(ptOffset_[ieta+1]-ptOffset_[ieta]);
+    if(n==0) return result_;
+    size_t i(0);
+    double f(0.);
+    if(pt>=nodes[n-1]) i=n-1;
+    else if(pt>=nodes[0]) {
+      i=std::upper_bound(nodes,nodes+n,pt)-nodes-1;
+      f=(pt-nodes[i])/(nodes[i+1]-nodes[i]);
+    }
+
+    const float *lo(&unc_[(ptOffset_[ieta]+i)*nval]);
+    if(f==0.) {
+      std::copy(lo,lo+nval,result_.begin());
+    }
+    else {
+      const float *hi(lo+nval);
+      for(size_t k=0; k<nval; k++) result_[k]=lo[k]+(hi[k]-lo[k])*f;
+    }
+    return result_;
+  }
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<double> etaLow_, etaHigh_;
+  std::vector<size_t> ptOffset_;
+  std::vector<double> ptNodes_;
+  std::vector<float> unc_;
+  std::vector<float> result_;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef MEWeightCompressor_h
+#define MEWeightCompressor_h
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+   @short compact storage of the ME/PDF weight ratios (to the nominal weight) written to the output tree
+
+   Two independent reductions are available:
+   - each registered Hessian set (a central member followed by its eigenvector members) is replaced by
+     its central, up and down ratios, evaluated event by event with the Hessian master formulas:
+     symmetric sets use sqrt(sum (r_i-r_0)^2), sets of +/- pairs use the asymmetric formulas.
+     The per-event envelope is not linear in the event weights: the exact sums of all the members
+     still need to be kept separately for the normalization.
+   - the ratios are quantised as 16-bit fixed point deltas around 1, ratio = 1 + q*PACKSTEP,
+     i.e. a resolution of 1.2e-4 in (-3,5). Values outside the range (including infinities) are saturated
+     and non-finite ratios (e.g. from a null nominal weight) are stored as PACKNAN.
+ */
+class MEWeightCompressor
+{
+
+ public:
+
+  static constexpr double PACKSTEP=1./8192.;
+  static const short PACKNAN=-32768;
+
+  MEWeightCompressor() : reduce_(false) { }
+
+  /**
+     @short registers a Hessian set by its position in the list of ratios
+     pairs=true for (+,-) pairs of members, false for symmetric eigenvectors
+   */
+  void addHessianSet(const std::string &name, size_t central, size_t firstMember, size_t nMembers, bool pairs)
+  {
+    sets_.push_back( HessianSet_t{name,central,firstMember,nMembers,pairs} );
+    role_.clear();
+  }
+
+  void setReduceHessian(bool reduce) { reduce_=reduce; }
+  bool reduceHessian() const { return reduce_ && !sets_.empty(); }
+
+  /**
+     @short labels of the stored ratios for an input of nRatios ratios
+   */
+  std::vector<std::string> labels(size_t nRatios) const
+  {
+    std::vector<std::string> out;
+    std::vector<int> role(roles(nRatios));
+    for(size_t i=0; i<nRatios; i++) {
+      if(role[i]==MEMBER) continue;
+      out.push_back("w"+std::to_string(i));
+      if(role[i]<0) continue;
+      out.push_back(sets_[role[i]].name+"Up");
+      out.push_back(sets_[role[i]].name+"Dn");
+    }
+    return out;
+  }
+
+  /**
+     @short returns the ratios to store, the Hessian sets being reduced if requested
+     the returned reference is valid until the next call
+   */
+  const std::vector<float> &compress(const std::vector<float> &ratios)
+  {
+    out_.clear();
+    if(!reduceHessian()) {
+      out_=ratios;
+      return out_;
+    }
+
+    if(role_.size()!=ratios.size()) role_=roles(ratios.size());
+    const std::vector<int> &role=role_;
+    for(size_t i=0; i<ratios.size(); i++) {
+      if(role[i]==MEMBER) continue;
+      out_.push_back(ratios[i]);
+      if(role[i]<0) continue;
+
+      const HessianSet_t &set=sets_[role[i]];
+      double r0(ratios[i]), up2(0), dn2(0);
+      if(set.pairs) {
+        for(size_t k=0; k+1<set.nMembers; k+=2) {
+          double dplus(ratios[set.first+k]-r0), dminus(ratios[set.first+k+1]-r0);
+          up2 += pow(std::max(std::max(dplus,dminus),0.),2);
+          dn2 += pow(std::max(std::max(-dplus,-dminus),0.),2);
+        }
+      }
+      else {
+        for(size_t k=0; k<set.nMembers; k++) up2 += pow(ratios[set.first+k]-r0,2);
+        dn2=up2;
+      }
+      out_.push_back(r0+sqrt(up2));
+      out_.push_back(r0-sqrt(dn2));
+    }
+    return out_;
+  }
+
+  /**
+     @short 16-bit fixed point representation of a ratio
+   */
+  static short pack(float ratio)
+  {
+    if(std::isnan(ratio)) return PACKNAN;
+    double q(std::round((ratio-1.)/PACKSTEP));
+    return short(std::min(std::max(q,-32767.),32767.));
+  }
+  static float unpack(short q) { return q==PACKNAN ? std::numeric_limits<float>::quiet_NaN() : 1.+q*PACKSTEP; }
+  static bool isPackable(float ratio) { return std::isfinite(ratio) && fabs((ratio-1.)/PACKSTEP)<32767.5; }
+
+ private:
+
+  struct HessianSet_t {
+    std::string name;
+    size_t central, first, nMembers;
+    bool pairs;
+  };
+
+  enum Role_t { KEPT=-1, MEMBER=-2 };
+
+  //for each ratio: KEPT, MEMBER (dropped) or the index of the set of which it is the central
+  //(sets which do not fit in the input are ignored)
+  std::vector<int> roles(size_t nRatios) const
+  {
+    std::vector<int> role(nRatios,KEPT);
+    for(size_t s=0; s<sets_.size(); s++) {
+      if(sets_[s].central>=nRatios || sets_[s].first+sets_[s].nMembers>nRatios) continue;
+      role[sets_[s].central]=s;
+      for(size_t k=0; k<sets_[s].nMembers; k++) role[sets_[s].first+k]=MEMBER;
+    }
+    return role;
+  }
+
+  bool reduce_;
+  std::vector<HessianSet_t> sets_;
+  std::vector<int> role_;   //roles for the last input size
+  std::vector<float> out_;
+};
+
+#endif
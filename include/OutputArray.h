@@ -0,0 +1,70 @@
+#ifndef OutputArray_h
+#define OutputArray_h
+
+#include "TTree.h"
+#include "TString.h"
+
+#include <memory>
+#include <vector>
+
+/**
+   @short per-object output branch, stored either as a std::vector or as a flat C array
+
+   In vector mode the branch is a std::vector<T> streamed with its own size.
+   In flat mode a C array of maxSize entries is allocated once and booked as name[counter],
+   so that all the arrays of a collection share the count branch (e.g. nlep) and no vector
+   streamer is involved. The count branch must be booked before and must not exceed maxSize:
+   push_back beyond maxSize is ignored.
+   The filling code (clear/push_back/operator[]) is the same for both modes.
+ */
+template<typename T>
+class OutputArray
+{
+
+ public:
+
+  OutputArray() : n_(0), maxSize_(0) { }
+
+  /**
+     @short books a std::vector branch
+   */
+  void book(TTree *t, const TString &name) { t->Branch(name,&vec_); }
+
+  /**
+     @short books a C-array branch sized by the counter branch
+   */
+  void book(TTree *t, const TString &name, const TString &counter, size_t maxSize)
+  {
+    maxSize_=maxSize;
+    arr_.reset(new T[maxSize_]());
+    t->Branch(name,arr_.get(),Form("%s[%s]/%c",name.Data(),counter.Data(),leafType()));
+  }
+
+  bool isFlat() const { return arr_ != nullptr; }
+
+  void clear() { vec_.clear(); n_=0; }
+
+  void push_back(const T &val)
+  {
+    if(!arr_)           vec_.push_back(val);
+    else if(n_<maxSize_) arr_[n_++]=val;
+  }
+
+  size_t size() const { return arr_ ? n_ : vec_.size(); }
+  T operator[](size_t i) const { return arr_ ? arr_[i] : vec_[i]; }
+
+ private:
+
+  static char leafType();
+
+  std::vector<T> vec_;
+  std::unique_ptr<T[]> arr_;
+  size_t n_, maxSize_;
+};
+
+template<> inline char OutputArray<Float_t>::leafType() { return 'F'; }
+template<> inline char OutputArray<Int_t>::leafType()   { return 'I'; }
+template<> inline char OutputArray<Short_t>::leafType() { return 'S'; }
+template<> inline char OutputArray<Bool_t>::leafType()  { return 'O'; }
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef OutputPolicy_h
+#define OutputPolicy_h
+
+#include "TBranch.h"
+#include "TFile.h"
+#include "TObjArray.h"
+#include "TString.h"
+#include "TStopwatch.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "RVersion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+   @short compression and basket layout of the output tree
+
+   The branches are grouped in classes (event variables, per-lepton, per-jet and ME weights) and
+   each policy sets the compression algorithm and level of each class:
+   - default: ROOT defaults (compression of the output file, 32 kB baskets, 30 MB clusters)
+   - analysis: LZ4 for the ntuples read many times, ZSTD for the weights (LZMA before ROOT 6.20)
+   - archive: ZSTD for the event and object variables, LZMA for the weights
+   For the other policies the baskets are sized so that each branch holds one cluster
+   of entries per basket, and the clusters (AutoFlush) are sized from the expected number of entries
+   and the estimated uncompressed size of an entry.
+ */
+class OutputPolicy
+{
+
+ public:
+
+  enum BranchClass { EVENT=0, LEPTON, JET, WEIGHT, NCLASSES };
+
+  //compression algorithms as in ROOT's Compression.h, settings are algorithm*100+level
+  enum Algorithm { ZLIB=1, LZMA=2, LZ4=4, ZSTD=5 };
+
+  OutputPolicy(const std::string &name="default") : name_(name)
+  {
+    std::fill(settings_,settings_+NCLASSES,-1);
+    int zstd(hasZSTD() ? ZSTD : LZMA);
+    if(name_=="analysis") {
+      settings_[EVENT]=settings_[LEPTON]=settings_[JET]=LZ4*100+4;
+      settings_[WEIGHT]=zstd*100+5;
+    }
+    else if(name_=="archive") {
+      settings_[EVENT]=settings_[LEPTON]=settings_[JET]=zstd*100+7;
+      settings_[WEIGHT]=LZMA*100+8;
+    }
+    else if(name_!="default") {
+      std::cout << "[OutputPolicy] unknown policy " << name_ << ", using the default one" << std::endl;
+      name_="default";
+    }
+  }
+
+  static std::vector<std::string> names() { return {"default","analysis","archive"}; }
+  static bool hasZSTD() { return ROOT_VERSION_CODE>=ROOT_VERSION(6,20,0); }
+
+  const std::string &name() const { return name_; }
+
+  /**
+     @short class of a top-level branch, from its name
+   */
+  static BranchClass branchClass(const TString &bname)
+  {
+    if(bname.BeginsWith("lep"))       return LEPTON;
+    if(bname.BeginsWith("bjet_"))     return JET;
+    if(bname.Contains("meWeights"))   return WEIGHT;
+    return EVENT;
+  }
+
+  /**
+     @short applies the policy to a tree before it is filled
+     expectedEntries is an upper bound on the number of entries (e.g. the events to process),
+     the multiplicities are the typical number of elements per entry of each class
+   */
+  void apply(TTree *t, Long64_t expectedEntries, const float multiplicity[NCLASSES]) const
+  {
+    TObjArray *branches=t->GetListOfBranches();
+
+    //ROOT defaults (needed for trees cloned from a tree with another policy)
+    if(name_=="default") {
+      t->SetAutoFlush(-30000000);
+      for(int i=0; i<branches->GetEntriesFast(); i++) {
+        TBranch *b=(TBranch *)branches->At(i);
+        t->SetBasketSize(b->GetName(),32000);
+        if(t->GetCurrentFile()) b->SetCompressionSettings(t->GetCurrentFile()->GetCompressionSettings());
+      }
+      return;
+    }
+
+    //rough estimate of the uncompressed size of each branch per entry
+    std::vector<double> bytes(branches->GetEntriesFast(),0.);
+    double totalBytes(0.);
+    for(int i=0; i<branches->GetEntriesFast(); i++) {
+      TBranch *b=(TBranch *)branches->At(i);
+      BranchClass bc(branchClass(b->GetName()));
+      bytes[i] = bc==EVENT ? 8. : 4.*std::max(multiplicity[bc],1.f)+8.;
+      totalBytes += bytes[i];
+    }
+
+    //clusters of about 32 MB uncompressed, bounded by the expected entries
+    Long64_t clusterEntries(std::max(Long64_t(32e6/std::max(totalBytes,1.)),Long64_t(1000)));
+    clusterEntries=std::min(clusterEntries,std::max(expectedEntries,Long64_t(1)));
+    t->SetAutoFlush(clusterEntries);
+
+    for(int i=0; i<branches->GetEntriesFast(); i++) {
+      TBranch *b=(TBranch *)branches->At(i);
+      int basketSize(std::min(std::max(bytes[i]*clusterEntries,4096.),8e6));
+      t->SetBasketSize(b->GetName(),basketSize);
+      b->SetCompressionSettings(settings_[branchClass(b->GetName())]);
+    }
+  }
+
+  /**
+     @short result of writing a tree with a policy
+   */
+  struct Benchmark_t {
+    std::string policy;
+    double writeTime, readTime;   //seconds (real time)
+    Long64_t fileSize;            //bytes
+  };
+
+  /**
+     @short copies all the entries of a tree to a temporary file with this policy
+     and measures the write time, the file size and the time to read it back
+     the write time only counts filling the copy and writing and closing the file, not reading the source entries
+   */
+  Benchmark_t benchmark(TTree *src, const TString &tmpURL, const float multiplicity[NCLASSES]) const
+  {
+    Benchmark_t result{name_,0.,0.,0};
+    TDirectory *prevDir=gDirectory;
+
+    TFile *fTmp=TFile::Open(tmpURL,"RECREATE");
+    if(!fTmp || fTmp->IsZombie()) return result;
+    TTree *copy=src->CloneTree(0);
+    copy->SetDirectory(fTmp);
+    apply(copy,src->GetEntries(),multiplicity);
+    typedef std::chrono::steady_clock Clock_t;
+    Clock_t::duration writeTime(0);
+    for(Long64_t i=0; i<src->GetEntries(); i++) {
+      src->GetEntry(i);
+      Clock_t::time_point start(Clock_t::now());
+      copy->Fill();
+      writeTime += Clock_t::now()-start;
+    }
+    Clock_t::time_point writeStart(Clock_t::now());
+    copy->Write();
+    fTmp->Close();
+    writeTime += Clock_t::now()-writeStart;
+    result.writeTime=std::chrono::duration<double>(writeTime).count();
+
+    FileStat_t stat;
+    if(gSystem->GetPathInfo(tmpURL,stat)==0) result.fileSize=stat.fSize;
+
+    TStopwatch sw;
+    fTmp=TFile::Open(tmpURL);
+    TTree *t=(TTree *)fTmp->Get(src->GetName());
+    for(Long64_t i=0; t && i<t->GetEntries(); i++) t->GetEntry(i);
+    fTmp->Close();
+    result.readTime=sw.RealTime();
+
+    gSystem->Unlink(tmpURL);
+    if(prevDir) prevDir->cd();
+    return result;
+  }
+
+ private:
+
+  std::string name_;
+  int settings_[NCLASSES];
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef QuenchingSampler_h
+#define QuenchingSampler_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+   @short samples the jet energy loss from the log-normal quenching model
+
+   The model is the log-normal density with log(x) ~ N(log(omega_c)-1.5, 0.73), truncated to (0,xmax].
+   The inverse of its cumulative distribution is tabulated once for each omega_c value requested and
+   sampled by linear interpolation in the table.
+   The random numbers are counter-based: they depend only on the seed, the event set with setEvent
+   and the counter (e.g. the jet index), so that the same jet gets the same loss wherever it is sampled.
+ */
+class QuenchingSampler
+{
+
+ public:
+
+  QuenchingSampler(double xmax=50., size_t nNodes=4096, uint64_t seed=42) :
+    xmax_(xmax), nNodes_(std::max(nNodes,size_t(2))), seed_(seed), key_(seed)
+    { }
+
+  /**
+     @short sets the key of the random number sequence for the current event
+   */
+  void setEvent(uint64_t run, uint64_t lumi, uint64_t event)
+  {
+    key_=mix(seed_ ^ mix(run ^ mix(lumi ^ mix(event))));
+  }
+
+  /**
+     @short uniform random number in (0,1) for a counter in the current event
+   */
+  double uniform(uint64_t counter) const
+  {
+    return ((mix(key_ + (counter+1)*0x9E3779B97F4A7C15ULL) >> 11) + 0.5) * (1.0/9007199254740992.0);
+  }
+
+  /**
+     @short energy loss for a given omega_c and counter in the current event
+   */
+  double sample(double omegaC, uint64_t counter) { return inverseCDF(omegaC, uniform(counter)); }
+
+  /**
+     @short quantile u of the energy loss distribution for a given omega_c
+   */
+  double inverseCDF(double omegaC, double u)
+  {
+    const std::vector<double> &q=table(omegaC);
+    double pos(std::min(std::max(u,0.),1.)*(nNodes_-1));
+    size_t i(std::min(size_t(pos),nNodes_-2));
+    return q[i]+(pos-i)*(q[i+1]-q[i]);
+  }
+
+ private:
+
+  //splitmix64 finalizer
+  static uint64_t mix(uint64_t z)
+  {
+    z=(z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z=(z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  //quantiles at u=i/(nNodes-1), built on first use by inverting the cumulative on a fine grid in log(x)
+  const std::vector<double> &table(double omegaC)
+  {
+    std::vector<double> &q=tables_[omegaC];
+    if(!q.empty()) return q;
+
+    const double sigma(0.73), mu(log(omegaC)-1.5);
+    const double zmin(-8.), zmax((log(xmax_)-mu)/sigma);
+    size_t nz(16*nNodes_);
+    std::vector<double> z(nz), cdf(nz);
+    for(size_t i=0; i<nz; i++) {
+      z[i]=zmin+(zmax-zmin)*i/(nz-1);
+      cdf[i]=0.5*erfc(-z[i]/sqrt(2.));
+    }
+    for(size_t i=0; i<nz; i++) cdf[i]=(cdf[i]-cdf[0])/(cdf[nz-1]-cdf[0]);
+
+    q.resize(nNodes_);
+    for(size_t k=0; k<nNodes_; k++) {
+      double u(double(k)/(nNodes_-1));
+      size_t j=std::lower_bound(cdf.begin(),cdf.end(),u)-cdf.begin();
+      double zk(z[0]);
+      if(j>=nz) zk=z[nz-1];
+      else if(j>0) zk=z[j-1]+(u-cdf[j-1])/(cdf[j]-cdf[j-1])*(z[j]-z[j-1]);
+      q[k]=exp(mu+sigma*zk);
+    }
+    return q;
+  }
+
+  double xmax_;
+  size_t nNodes_;
+  uint64_t seed_, key_;
+  std::map<double,std::vector<double> > tables_;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef RNTupleOutput_h
+#define RNTupleOutput_h
+
+#include "TString.h"
+#include "TStopwatch.h"
+#include "RVersion.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,32,0)
+#define TOPSKIM_HAS_RNTUPLE 1
+#include <ROOT/RNTupleImporter.hxx>
+#include <ROOT/RDataFrame.hxx>
+#endif
+
+/**
+   @short RNTuple output of the 2L tree
+
+   The tree is filled as usual in a temporary file and imported at the end of the job as an RNTuple
+   with the same name in the output file: scalar branches become fields of the same type and
+   std::vector branches become collection fields, so that the column names are unchanged.
+   Requires ROOT >= 6.32, isAvailable() is false otherwise.
+ */
+class RNTupleOutput
+{
+
+ public:
+
+#ifdef TOPSKIM_HAS_RNTUPLE
+  static bool isAvailable() { return true; }
+#else
+  static bool isAvailable() { return false; }
+#endif
+
+  /**
+     @short imports the tree of a file as an RNTuple in the output file (created or updated)
+   */
+  static bool convert(const TString &treeURL, const TString &treeName, const TString &outURL)
+  {
+#ifdef TOPSKIM_HAS_RNTUPLE
+    try {
+      auto importer=ROOT::Experimental::RNTupleImporter::Create(treeURL.Data(),treeName.Data(),outURL.Data());
+      importer->SetIsQuiet(true);
+      importer->Import();
+      return true;
+    }
+    catch(const std::exception &e) {
+      std::cout << "[RNTupleOutput] failed to import " << treeName << " from " << treeURL << ": " << e.what() << std::endl;
+    }
+#endif
+    return false;
+  }
+
+  /**
+     @short result of the same selection run on the TTree and on the RNTuple
+   */
+  struct ReadBenchmark_t {
+    double treeTime, ntupleTime;        //seconds (real time, best of the timed runs)
+    double treeSumw, ntupleSumw;        //sum of the weights of the selected events
+  };
+
+  /**
+     @short runs a dilepton+b selection on both formats, reading the leptons, the dilepton mass,
+     the number of b-tagged jets and the weights
+     The selection is compiled (typed lambdas, no JIT) and each format is read once untimed to warm up
+     the file caches, then nRepeat times each in alternating order (tree, RNTuple, RNTuple, tree, ...).
+   */
+  static ReadBenchmark_t benchmarkRead(const TString &treeURL, const TString &ntupleURL, const TString &name, int nRepeat=2)
+  {
+    ReadBenchmark_t result{0.,0.,0.,0.};
+#ifdef TOPSKIM_HAS_RNTUPLE
+    auto run=[&name](const TString &url, double &sumw) {
+      TStopwatch sw;
+      ROOT::RDataFrame df(name.Data(),url.Data());
+      sumw=df.Filter([](int nlep, const ROOT::RVec<float> &lep_pt, float llm, int nbjet_sel) {
+                       return nlep>=2 && lep_pt[0]>25 && lep_pt[1]>20 && llm>20 && nbjet_sel>=1; },
+                     {"nlep","lep_pt","llm","nbjet_sel"})
+             .Define("wgt",[](float weight, const ROOT::RVec<float> &lepSF) { return weight*lepSF[0]*lepSF[1]; },
+                     {"weight","lepSF"})
+             .Sum<float>("wgt").GetValue();
+      return sw.RealTime();
+    };
+    run(treeURL,result.treeSumw);
+    run(ntupleURL,result.ntupleSumw);
+    result.treeTime=result.ntupleTime=-1;
+    for(int i=0; i<2*std::max(nRepeat,1); i++) {
+      bool tree((i%4==0) || (i%4==3));
+      double &best(tree ? result.treeTime : result.ntupleTime);
+      double time(run(tree ? treeURL : ntupleURL, tree ? result.treeSumw : result.ntupleSumw));
+      best = best<0 ? time : std::min(best,time);
+    }
+#endif
+    return result;
+  }
+};
+
+#endif
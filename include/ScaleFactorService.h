@@ -0,0 +1,186 @@
+#ifndef ScaleFactorService_h
+#define ScaleFactorService_h
+
+#include "HeavyIonsAnalysis/topskim/include/tnp_weight.h"
+#include "HeavyIonsAnalysis/topskim/include/tnp_electrons.h"
+#include "HeavyIonsAnalysis/topskim/include/BinnedSF2D.h"
+#include "HeavyIonsAnalysis/topskim/include/GraphLookup.h"
+
+#include "TFile.h"
+#include "TGraphAsymmErrors.h"
+#include "TLorentzVector.h"
+#include "TString.h"
+#include "TSystem.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+/**
+   @short scale factors and trigger efficiency of a single lepton
+ */
+struct LeptonSF_t {
+  float sf, sfUnc;          //identification x reconstruction/tracking
+  float isoSF, isoSFUnc;    //isolation
+  float trigEff;            //expected trigger efficiency in MC
+  float trigSF, trigSFUnc;  //trigger
+};
+
+/**
+   @short scale factors of the selected dilepton and the combined event trigger scale factor
+ */
+struct EventSF_t {
+  LeptonSF_t lep[2];
+  float trigSF, trigSFUnc;
+};
+
+/**
+   @short single entry point for the lepton scale factors
+
+   All the tables (muon tag-and-probe, electron ID/RECO/HLT, isolation and expected electron
+   trigger efficiency) are loaded once at construction. evaluate() computes all the scale
+   factors, their uncertainties and the dilepton trigger scale factor for the selected pair.
+   Out-of-range inputs are reported once per condition through the counted diagnostics.
+ */
+class ScaleFactorService
+{
+
+ public:
+
+  /**
+     @short CTOR - loads all the tables from the data directory given
+     barrelMaxEta is the |eta| boundary used to select the barrel electron scale factors
+   */
+  ScaleFactorService(TString dataDir, float barrelMaxEta) :
+    eleEff_(dataDir, false),
+    barrelMaxEta_(barrelMaxEta)
+    {
+      //expected electron trigger efficiencies: the graph is copied to a lookup table and not kept
+      TString trigEffURL(dataDir+"/trigeff_mc.root");
+      gSystem->ExpandPathName(trigEffURL);
+      TFile *fIn=TFile::Open(trigEffURL);
+      TGraphAsymmErrors *gr=(TGraphAsymmErrors *)fIn->Get("e_pt_trigeff");
+      eTrigEff_.load(gr);
+      delete gr;
+      fIn->Close();
+
+      //isolation scale factors: indexed by [central/peripheral][electron/muon], pt beyond the last bin uses the last bin
+      //and pt below the first bin the underflow (empty, i.e. the fallback value)
+      TString isosfURL(dataDir+"/isolation_sf.root");
+      gSystem->ExpandPathName(isosfURL);
+      fIn=TFile::Open(isosfURL);
+      TString isocen[]={"cen","periph"}, isolep[]={"121","169"};
+      for(size_t i=0; i<2; i++){
+        for(size_t j=0; j<2; j++){
+          TH2 *h=(TH2*)fIn->Get("sfiso2eff_"+isocen[i]+"_"+isolep[j]);
+          isoSFs_[i][j].load(h,true,false);
+        }
+      }
+      fIn->Close();
+    }
+
+  /**
+     @short expected trigger efficiency in MC for an electron, linearly interpolated in pt
+   */
+  double electronTrigEff(double pt) const { return eTrigEff_.eval(pt); }
+
+  /**
+     @short evaluates the scale factors of a single lepton (pdgId, p4) for a given centrality
+   */
+  void evaluate(int id, const TLorentzVector &p4, float cenBin, LeptonSF_t &sf)
+  {
+    float pt(p4.Pt()),eta(p4.Eta()),abseta(fabs(eta));
+    bool isMuon(abs(id)==13);
+
+    //trigger: expected efficiency and measured scale factor
+    if(!isMuon){
+      bool isEB(abseta<barrelMaxEta_);
+      sf.trigEff=eTrigEff_.eval(pt);
+      std::pair<float,float> hlt=eleEff_.eval(pt, isEB, cenBin, true, false); //HLT (L1 is unity by definition in this trigger menu)
+      sf.trigSF=hlt.first;
+      sf.trigSFUnc=hlt.second;
+    }else{
+      TnPWeight_t mutrig=tnp_weights_trig_pbpb(pt,eta,cenBin);
+      tnp_report(mutrig,"tnp_weight_trig_pbpb",pt,eta,cenBin);
+      sf.trigEff=mutrig.nominal;
+      sf.trigSF=mutrig.nominal;
+      float deltaTnp=std::max(fabs(sf.trigSF-mutrig.systUp),fabs(sf.trigSF-mutrig.systDown));
+      float deltaStat=std::max(fabs(sf.trigSF-mutrig.statUp),fabs(sf.trigSF-mutrig.statDown));
+      sf.trigSFUnc=sqrt(deltaTnp*deltaTnp+deltaStat*deltaStat);
+    }
+
+    //reco/tracking+id scale factors
+    float sfVal(1.0),sfValUnc(0.0);
+    if(isMuon) {
+      //ID
+      TnPWeight_t muid=tnp_weights_muid_pbpb(eta);
+      tnp_report(muid,"tnp_weight_muid_pbpb",pt,eta,cenBin);
+      sfVal=muid.nominal;                                    //central value
+      sfValUnc += pow(fabs(muid.statUp-sfVal),2);            //stat, +1 sigma
+      sfValUnc += pow(fabs(muid.systUp-sfVal),2);            //syst, +1 sigma
+      sfValUnc += pow(fabs(muid.statDown-sfVal),2);          //stat, -1 sigma
+      sfValUnc += pow(fabs(muid.systDown-sfVal),2);          //syst, -1 sigma
+      sfValUnc += pow(0.01,2);                               //identification centrality dependence
+      //Tracking
+      TnPWeight_t glbtrk=tnp_weights_glbtrk_pbpb(eta,cenBin);
+      tnp_report(glbtrk,"tnp_weight_glbtrk_pbpb",pt,eta,cenBin);
+      sfVal*=glbtrk.nominal;                                 //central value
+      sfValUnc += pow(fabs(glbtrk.statUp-sfVal),2);          //stat, +1 sigma
+      sfValUnc += pow(fabs(glbtrk.systUp-sfVal),2);          //syst, +1 sigma
+      sfValUnc += pow(fabs(glbtrk.statDown-sfVal),2);        //stat, -1 sigma
+      sfValUnc += pow(fabs(glbtrk.systDown-sfVal),2);        //syst, -1 sigma
+      sfValUnc = sqrt(sfValUnc);
+    }else {
+      bool isEB(abseta<barrelMaxEta_);
+      std::pair<float,float > eleIDsf=eleEff_.eval(pt, isEB, cenBin, false, false);  //ID
+      sfVal=eleIDsf.first;
+      sfValUnc=eleIDsf.second;
+      std::pair<float,float > eleRECOsf=eleEff_.eval(pt, isEB, cenBin, false, true); //RECO
+      sfValUnc = sqrt(pow(sfValUnc/sfVal,2)+pow(eleRECOsf.second/eleRECOsf.first,2));
+      sfVal*=eleRECOsf.first;
+    }
+    sf.sf=sfVal;
+    sf.sfUnc=sfValUnc;
+
+    //isolation (empty bins are assigned a 5% uncertainty)
+    std::pair<float,float> isoSF=isoSFs_[cenBin<30 ? 0 : 1][isMuon ? 1 : 0].eval(pt,abseta);
+    if(isoSF.first != 0.){
+      sf.isoSF=isoSF.first;
+      sf.isoSFUnc=isoSF.second;
+    }else{
+      sf.isoSF=1.00;
+      sf.isoSFUnc=0.05;
+    }
+  }
+
+  /**
+     @short evaluates the scale factors of the selected dilepton, the result is kept until the next call
+   */
+  const EventSF_t &evaluate(int id1, const TLorentzVector &p1, int id2, const TLorentzVector &p2, float cenBin)
+  {
+    evaluate(id1,p1,cenBin,evSF_.lep[0]);
+    evaluate(id2,p2,cenBin,evSF_.lep[1]);
+
+    //trigeff = e1*e2 +e1*(1-e2)+e2*(1-e1), the rest is scale factor and error propagation
+    const LeptonSF_t &l1=evSF_.lep[0], &l2=evSF_.lep[1];
+    float trigSF  = (l1.trigSF*l1.trigEff+l2.trigSF*l2.trigEff-l1.trigSF*l2.trigSF*l1.trigEff*l2.trigEff);
+    trigSF /= (l1.trigEff+l2.trigEff-l1.trigEff*l2.trigEff);
+    evSF_.trigSF=trigSF;
+
+    float trigSFUnc  = pow( l1.trigSFUnc*(l1.trigEff-l2.trigSF*l1.trigEff*l2.trigEff), 2 );
+    trigSFUnc += pow( l2.trigSFUnc*(l2.trigEff-l1.trigSF*l1.trigEff*l2.trigEff), 2 );
+    evSF_.trigSFUnc=sqrt(trigSFUnc);
+
+    return evSF_;
+  }
+
+ private:
+
+  ElectronEfficiencyWrapper eleEff_;
+  float barrelMaxEta_;
+  GraphLookup eTrigEff_;
+  BinnedSF2D isoSFs_[2][2];
+  EventSF_t evSF_;
+};
+
+#endif
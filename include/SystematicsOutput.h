@@ -0,0 +1,137 @@
+#ifndef SystematicsOutput_h
+#define SystematicsOutput_h
+
+#include "TDirectory.h"
+#include "TObjArray.h"
+#include "TString.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <vector>
+
+/**
+   @short one systematic variation: its derived quantities and the function computing them
+ */
+class SystVariation
+{
+
+ public:
+
+  typedef std::function<void()> Compute_t;
+
+  SystVariation(const TString &name) : name_(name), tree_(nullptr) { }
+
+  const TString &name() const { return name_; }
+  TString treeName() const { return "syst_"+name_; }
+  TTree *tree() const { return tree_; }
+
+  /**
+     @short registers a quantity, the returned reference stays valid for the lifetime of the variation
+   */
+  Int_t &addInt(const TString &qty)     { ints_.push_back(0);  intNames_.push_back(qty);   return ints_.back(); }
+  Float_t &addFloat(const TString &qty) { floats_.push_back(0); floatNames_.push_back(qty); return floats_.back(); }
+
+  void setCompute(Compute_t compute) { compute_=compute; }
+
+ private:
+
+  friend class SystematicsOutput;
+
+  void book(TDirectory *dir)
+  {
+    TDirectory *prevDir=gDirectory;
+    if(dir) dir->cd();
+    tree_=new TTree(treeName(),"derived quantities for the "+name_+" variation");
+    for(size_t i=0; i<ints_.size(); i++)   tree_->Branch(intNames_[i],   &ints_[i],   intNames_[i]+"/I");
+    for(size_t i=0; i<floats_.size(); i++) tree_->Branch(floatNames_[i], &floats_[i], floatNames_[i]+"/F");
+    if(prevDir) prevDir->cd();
+  }
+
+  TString name_;
+  std::deque<Int_t> ints_;
+  std::deque<Float_t> floats_;
+  std::vector<TString> intNames_, floatNames_;
+  Compute_t compute_;
+  TTree *tree_;
+};
+
+/**
+   @short systematic variations written to friend trees aligned entry by entry with the nominal tree
+
+   Each variation registers its own quantities and the function computing them, and is written to
+   a tree named syst_<variation> with one entry per entry of the nominal tree, e.g.
+     tree->AddFriend("syst_jecup"); tree->Draw("syst_jecup.nbjet_sel");
+   Only the variations enabled by the comma-separated list given at construction ("all" for all of them)
+   are booked, computed and written: addVariation returns a null pointer for the other ones.
+ */
+class SystematicsOutput
+{
+
+ public:
+
+  SystematicsOutput(const TString &list="") : all_(false)
+  {
+    std::unique_ptr<TObjArray> tkns(list.Tokenize(","));
+    for(int i=0; i<tkns->GetEntriesFast(); i++) {
+      TString name(tkns->At(i)->GetName());
+      name=name.Strip(TString::kBoth);
+      if(name=="all") all_=true;
+      else if(name!="") requested_.insert(name);
+    }
+  }
+
+  /**
+     @short registers a variation, returns it if it is enabled and a null pointer otherwise
+   */
+  SystVariation *addVariation(const TString &name)
+  {
+    registered_.push_back(name);
+    if(!all_ && requested_.find(name)==requested_.end()) return nullptr;
+    variations_.push_back(std::unique_ptr<SystVariation>(new SystVariation(name)));
+    return variations_.back().get();
+  }
+
+  const std::vector<std::unique_ptr<SystVariation> > &variations() const { return variations_; }
+  bool empty() const { return variations_.empty(); }
+
+  /**
+     @short books the friend trees of the enabled variations (after all the quantities are registered)
+     and reports the requested variations which were not registered
+   */
+  void book(TDirectory *dir)
+  {
+    for(auto &v : variations_) v->book(dir);
+    for(auto &name : requested_) {
+      if(std::find(registered_.begin(),registered_.end(),name)!=registered_.end()) continue;
+      std::cout << "[SystematicsOutput] unknown variation " << name << ", available ones are:";
+      for(auto &r : registered_) std::cout << " " << r;
+      std::cout << std::endl;
+    }
+  }
+
+  /**
+     @short computes the quantities of all the enabled variations for the current event
+   */
+  void compute() { for(auto &v : variations_) if(v->compute_) v->compute_(); }
+
+  /**
+     @short fills the friend trees, to be called each time the nominal tree is filled
+   */
+  void fill() { for(auto &v : variations_) v->tree_->Fill(); }
+
+  void write() { for(auto &v : variations_) { v->tree_->GetDirectory()->cd(); v->tree_->Write(); } }
+
+ private:
+
+  bool all_;
+  std::set<TString> requested_;
+  std::vector<TString> registered_;
+  std::vector<std::unique_ptr<SystVariation> > variations_;
+};
+
+#endif
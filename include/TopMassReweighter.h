@@ -0,0 +1,90 @@
+#ifndef TopMassReweighter_h
+#define TopMassReweighter_h
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+/**
+   @short reweights the generated top quark masses from a nominal (m,Gamma) to a grid of (m,Gamma) points
+
+   The relativistic Breit-Wigner is evaluated analytically and its normalization for each grid point
+   (integrated in [max(0,m-50Gamma),m+50Gamma] of the grid point, also for the nominal shape) is
+   computed once at construction with the closed form of the integral.
+   The constant factor in front of the Breit-Wigner cancels in the weights and is not computed.
+ */
+class TopMassReweighter
+{
+
+ public:
+
+  /**
+     @short CTOR - grid is a list of (mass,width) pairs, the weights are returned in the same order
+   */
+  TopMassReweighter(float m0, float g0, const std::vector<std::pair<float,float> > &grid, float minObsMass=150.) :
+    m0_(m0), g0_(g0), minObsMass_(minObsMass), grid_(grid)
+    {
+      for(auto &p : grid_) {
+        double m(p.first), g(p.second), xmin(std::max(m-50*g,0.)), xmax(m+50*g);
+        norm_.push_back(integral(xmin,xmax,m,g));
+        norm0_.push_back(integral(xmin,xmax,m0_,g0_));
+      }
+      weights_.resize(grid_.size(),1.);
+    }
+
+  size_t size() const { return grid_.size(); }
+  float mass(size_t i) const { return grid_[i].first; }
+  float width(size_t i) const { return grid_[i].second; }
+
+  /**
+     @short returns the weights for all the grid points given the masses of the top and anti-top
+     all weights are 1 unless there are exactly two masses above the minimum
+   */
+  const std::vector<float> &weights(const std::vector<float> &obsm)
+  {
+    std::fill(weights_.begin(),weights_.end(),1.);
+    if(obsm.size()!=2 || obsm[0]<minObsMass_ || obsm[1]<minObsMass_) return weights_;
+
+    double s0(1.);
+    for(auto x : obsm) s0 *= shape(x,m0_,g0_);
+    for(size_t i=0; i<grid_.size(); i++) {
+      double s(1.);
+      for(auto x : obsm) s *= shape(x,grid_[i].first,grid_[i].second);
+      weights_[i] = (s/pow(norm_[i],2)) / (s0/pow(norm0_[i],2));
+    }
+    return weights_;
+  }
+
+  /**
+     @short x-dependent part of the relativistic Breit-Wigner
+   */
+  static double shape(double x, double m, double g)
+  {
+    return 1./(pow(x*x-m*m,2)+pow(m*g,2));
+  }
+
+  /**
+     @short integral of the shape in [a,b]
+     the quartic denominator is factorized as (x^2+sx+R^2)(x^2-sx+R^2), with R^4=m^4+m^2g^2
+   */
+  static double integral(double a, double b, double m, double g)
+  {
+    double R2(m*sqrt(m*m+g*g)), s(sqrt(2*(R2+m*m)));
+    double D(sqrt(2*m*g*g/(sqrt(m*m+g*g)+m)));   //sqrt(4R^2-s^2)=sqrt(2(R^2-m^2)), without cancellations
+    double B(0.5/R2), A(B/s);
+    auto F=[&](double x) {
+      return 0.5*A*log((x*x+s*x+R2)/(x*x-s*x+R2)) + (B/D)*(atan((2*x+s)/D)+atan((2*x-s)/D));
+    };
+    return F(b)-F(a);
+  }
+
+ private:
+
+  float m0_, g0_, minObsMass_;
+  std::vector<std::pair<float,float> > grid_;
+  std::vector<double> norm_, norm0_;
+  std::vector<float> weights_;
+};
+
+#endif
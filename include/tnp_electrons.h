@@ -1,48 +1,55 @@
 #ifndef tnp_electrons_h
 #define tnp_electrons_h
 
+#include "HeavyIonsAnalysis/topskim/include/CountedDiagnostics.h"
 #include "TFile.h"
 #include "TGraphAsymmErrors.h"
 #include "TString.h"
-#include "TObjString.h"
-#include <map>
+#include "TSystem.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
 
 /**
    @short reads scale factors for ID/HLT for electrons
+
+   The graphs are flattened at construction in arrays indexed by (region, centrality, type)
+   with the x nodes sorted, so that eval is a binary search for the closest node.
  */
 class ElectronEfficiencyWrapper
 {
 
  public:
 
+  enum Region { EB=0, EE, NREGIONS };
+  enum Centrality { CEN0_30=0, CEN30_100, NCENTRALITIES };
+  enum SFType { ID=0, HLT, RECO, NTYPES };
+
   /**
      @short CTOR - just parses all the files from the directory given
    */
-  ElectronEfficiencyWrapper(TString url,bool useOldId=true) 
+  ElectronEfficiencyWrapper(TString url,bool useOldId=true)
     {
-      TString baseF("ScaleFactors_PbPb_LooseWP");
-      TString regs[2]={"EB","EE"};
-      TString centr[2]={"0_30","30_100"};
-      TString pfix[3]={useOldId ? "_AlpaFixedDataOnly_BWResCBErfExp_preliminary_v2" : "" ,"_HLT","_RECO"};
-      for(size_t i=0; i<2; i++) {
-        for(size_t j=0; j<2; j++) {
-          for(size_t k=0; k<3; k++) {
-            TString path(Form("%s/%s_%s_Centr_%s%s.root",
-                              url.Data(),
-                              baseF.Data(),
-                              regs[i].Data(),
-                              centr[j].Data(),
-                              pfix[k].Data()));
+      //files are ScaleFactors_PbPb_LooseWP_<region>_Centr_<centrality><suffix>.root
+      //the suffix depends on the type and, for the ID, on the version of the identification
+      const char *regs[NREGIONS]={"EB","EE"};
+      const char *centr[NCENTRALITIES]={"0_30","30_100"};
+      const char *suffix[NTYPES][2]={ {"", "_AlpaFixedDataOnly_BWResCBErfExp_preliminary_v2"}, //ID (new, old)
+                                      {"_HLT","_HLT"},                                          //HLT
+                                      {"_RECO","_RECO"} };                                      //RECO
+      for(size_t i=0; i<NREGIONS; i++) {
+        for(size_t j=0; j<NCENTRALITIES; j++) {
+          for(size_t k=0; k<NTYPES; k++) {
+            TString path(Form("%s/ScaleFactors_PbPb_LooseWP_%s_Centr_%s%s.root",
+                              url.Data(),regs[i],centr[j],suffix[k][useOldId]));
             gSystem->ExpandPathName(path);
             TFile *f=TFile::Open(path);
-            TString key(regs[i]+centr[j]+pfix[k]);
-	    TObjArray *tx = key.Tokenize("_");
-	    for (Int_t t = 0; t < tx->GetEntries(); t++) {
-	      if (t==0) {key.Clear(); key.Append(((TObjString *)(tx->At(t)))->String()+"_");}
-	      else if (t<=2) if (t==2 and !pfix[k].Contains("HLT") and !pfix[k].Contains("RECO")) continue; else key.Append(((TObjString *)(tx->At(t)))->String()+"_");
-	      else continue; 
-	    }
-	    sfs_[key]=(TGraphAsymmErrors *)f->Get("g_scalefactors");
+            if(f==0 || f->IsZombie()) {
+              std::cout << "Unable to open " << path << " for electron SFs..." << std::endl;
+              continue;
+            }
+            TGraphAsymmErrors *gr=(TGraphAsymmErrors *)f->Get("g_scalefactors");
+            if(gr) flatten(gr,x_[i][j][k],sf_[i][j][k],sfUnc_[i][j][k]);
             f->Close();
           }
         }
@@ -53,37 +60,49 @@ class ElectronEfficiencyWrapper
      @short returns the SF and the uncertainty
    */
   std::pair<float,float> eval(float pt, bool isEB, int cenbin, bool hlt, bool reco) {
-
-    std::pair<float,float> sfVal(1.0,0.0);
-
-    //build the key to the map
-    TString reg(isEB ? "EB" : "EE");
-    TString cen(cenbin<30 ? "0_30" : "30_100");
-    TString pfix("_");
-    if(hlt) pfix.Append("HLT_");
-    if(reco) pfix.Append("RECO_");
-    TString key(reg+cen+pfix);
-    //check key exists
-    if(sfs_.find(key)==sfs_.end()) {
-      std::cout << "Unable to find " << key << " in electron SFs map..." << std::endl;
-      return sfVal;
+    if(hlt && reco) {
+      diagnostics().report("Unable to find HLT+RECO in electron SFs...",pt);
+      return std::pair<float,float>(1.0,0.0);
     }
+    return eval(pt, isEB ? EB : EE, cenbin<30 ? CEN0_30 : CEN30_100, hlt ? HLT : (reco ? RECO : ID));
+  }
 
-    //find closest value in x (prefer to spline interpolation)
-    Double_t x,y,mindiff(9.e+6);
-    for(int i=0; i<sfs_[key]->GetN(); i++){
-      sfs_[key]->GetPoint(i,x,y);
-      if(fabs(x-pt)>mindiff) continue;
-      mindiff=fabs(x-pt);
-      sfVal.first=float(y);
-      sfVal.second=sfs_[key]->GetErrorY(i);
-    }
+  /**
+     @short returns the SF and the uncertainty at the closest node in x (prefer to spline interpolation)
+   */
+  std::pair<float,float> eval(float pt, Region reg, Centrality cen, SFType type) const {
 
-    return sfVal;
+    const std::vector<double> &x=x_[reg][cen][type];
+    size_t n(x.size());
+    if(n==0) return std::pair<float,float>(1.0,0.0);
+
+    //closest node, ties are resolved in favour of the largest x as in a sequential scan
+    size_t i=std::upper_bound(x.begin(),x.end(),double(pt))-x.begin();
+    if(i==n) i=n-1;
+    else {
+      size_t r=std::upper_bound(x.begin()+i,x.end(),x[i])-x.begin()-1;
+      i = (i==0 || fabs(x[r]-pt)<=fabs(x[i-1]-pt)) ? r : i-1;
+    }
+    return std::pair<float,float>(sf_[reg][cen][type][i],sfUnc_[reg][cen][type][i]);
   }
 
  private:
-  std::map< TString, TGraphAsymmErrors *> sfs_;
+
+  //copies the graph points sorted in x (stable, so that repeated x keep their order)
+  static void flatten(TGraphAsymmErrors *gr,std::vector<double> &x,std::vector<float> &y,std::vector<float> &ey)
+  {
+    std::vector<int> idx(gr->GetN());
+    for(int i=0; i<gr->GetN(); i++) idx[i]=i;
+    std::stable_sort(idx.begin(),idx.end(),[gr](int a,int b){ return gr->GetX()[a]<gr->GetX()[b]; });
+    for(auto i : idx) {
+      x.push_back(gr->GetX()[i]);
+      y.push_back(float(gr->GetY()[i]));
+      ey.push_back(gr->GetErrorY(i));
+    }
+  }
+
+  std::vector<double> x_[NREGIONS][NCENTRALITIES][NTYPES];
+  std::vector<float> sf_[NREGIONS][NCENTRALITIES][NTYPES], sfUnc_[NREGIONS][NCENTRALITIES][NTYPES];
 
 };
 
@@ -1,8 +1,9 @@
 #ifndef tnp_weight_h
 #define tnp_weight_h
 
+#include "HeavyIonsAnalysis/topskim/include/CountedDiagnostics.h"
 #include "TMath.h"
-#include <iostream>
+#include <algorithm>
 
 // IN THIS FILE YOU WILL FIND:
 // ++++++++++++++
@@ -34,6 +35,25 @@
 // For all:
 //   * idx = +200: tnp efficiency for data
 //   * idx = +300: tnp efficiency for MC
+//
+// The tnp_weights_* functions return all the variations above from a single lookup
+// and should be preferred when more than one variation is needed.
+// Outside the validity range all the variations are set to 1 and the status is set:
+// they don't print, use tnp_report to route the status to the counted diagnostics.
+
+// ALL THE VARIATIONS AT ONCE
+// ++++++++++++++++++++++++++
+enum TnPStatus_t { TNP_OK=0, TNP_PT_BELOW_RANGE, TNP_ETA_OUT_OF_RANGE, TNP_CENT_OUT_OF_RANGE };
+
+struct TnPWeight_t {
+  double nominal, statUp, statDown, systUp, systDown, effData, effMC;
+  int status;
+};
+
+TnPWeight_t tnp_weights_glbtrk_pbpb(double eta, double cent) noexcept;
+TnPWeight_t tnp_weights_muid_pbpb(double eta) noexcept;
+TnPWeight_t tnp_weights_trig_pbpb(double pt, double eta, double cent) noexcept;
+void tnp_report(const TnPWeight_t &w, const char *name, double pt, double eta, double cent);
 
 // THE INDIVIDUAL SFs
 // ++++++++++++++++++
@@ -41,661 +61,330 @@ double tnp_weight_glbtrk_pbpb(double eta, double cent, int idx = 0);
 double tnp_weight_muid_pbpb(double eta, int idx=0);
 double tnp_weight_trig_pbpb(double pt, double eta, double cent, int idx=0);
 
+///////////////////////////////////////////////////
+//              T A B L E S                      //
+///////////////////////////////////////////////////
+namespace tnp_tables {
+
+  //bin edges in eta, the bins are (lo,hi] except for the first one which includes -2.4
+  constexpr int glbtrkNEta = 10;
+  constexpr double glbtrkEtaEdges[glbtrkNEta+1] = { -2.4, -2.1, -1.6, -1.2, -0.9, 0, 0.9, 1.2, 1.6, 2.1, 2.4 };
+
+  //centrality bins [0,40) and [40,100]
+  constexpr int glbtrkNCent = 2;
+  constexpr double glbtrkEffMC[glbtrkNCent][glbtrkNEta] = {
+    { 0.955981, 0.976366, 0.977068, 0.973544, 0.970051, 0.969666, 0.972616, 0.978239, 0.980999, 0.962922 },
+    { 0.985973, 0.99412, 0.996646, 0.991832, 0.985575, 0.985295, 0.992634, 0.996896, 0.994506, 0.987764 }
+  };
+
+  //data efficiency: nominal, stat up, stat down, syst up, syst down
+  constexpr double glbtrkEffData[glbtrkNCent][5][glbtrkNEta] = {
+    {
+      { 0.895748, 0.961812, 0.963615, 0.953689, 0.960387, 0.959435, 0.935934, 0.968385, 0.97469, 0.940124 },
+      { 0.912779, 0.96884, 0.968562, 0.960157, 0.963199, 0.962357, 0.943263, 0.97301, 0.981141, 0.959268 },
+      { 0.878718, 0.954599, 0.958397, 0.946923, 0.957485, 0.956421, 0.928318, 0.963989, 0.968032, 0.921065 },
+      { 0.912388, 0.965296, 0.965531, 0.955926, 0.961333, 0.960196, 0.937628, 0.971776, 0.97886, 0.947469 },
+      { 0.879108, 0.958329, 0.961699, 0.951452, 0.959441, 0.958675, 0.934239, 0.964993, 0.97052, 0.932779 }
+    },
+    {
+      { 1, 0.986484, 0.998253, 0.987887, 0.987426, 0.981425, 0.984663, 0.992795, 0.983557, 0.954671 },
+      { 1, 0.99644, 1, 0.994144, 0.992029, 0.987024, 0.992709, 0.997686, 0.991048, 0.979823 },
+      { 0.979675, 0.974748, 0.993399, 0.978866, 0.98235, 0.974871, 0.974046, 0.985567, 0.974474, 0.92457 },
+      { 1.0107, 0.992138, 0.999945, 0.988701, 0.988734, 0.985979, 0.987238, 0.994278, 0.98701, 0.960013 },
+      { 0.989305, 0.980829, 0.99656, 0.987074, 0.986119, 0.976872, 0.982088, 0.991312, 0.980103, 0.949328 }
+    }
+  };
+
+  //bin edges in eta, the bins are (lo,hi] except for the first one which includes -2.4
+  constexpr int muidNEta = 14;
+  constexpr double muidEtaEdges[muidNEta+1] = { -2.4, -2.1, -1.6, -1.2, -0.9, -0.6, -0.3, 0, 0.3, 0.6, 0.9, 1.2, 1.6, 2.1, 2.4 };
+  constexpr double muidEffMC[muidNEta] = { 0.994139, 0.99449, 0.983536, 0.964562, 0.973316, 0.981446, 0.968189, 0.9617, 0.979738, 0.969536, 0.960259, 0.983279, 0.99477, 0.994065 };
+
+  //data efficiency: nominal, stat up, stat down (the syst is a flat relative uncertainty)
+  constexpr double muidSyst = 0.6e-2;
+  constexpr double muidEffData[3][muidNEta] = {
+    { 0.984278, 0.994031, 0.978562, 0.954321, 0.966508, 0.98402, 0.958369, 0.959429, 0.976528, 0.967646, 0.961046, 0.980274, 0.991677, 0.993007 },
+    { 0.987203, 0.995641, 0.981641, 0.958889, 0.970274, 0.986882, 0.962433, 0.96344, 0.979706, 0.971414, 0.965537, 0.983167, 0.99336, 0.995579 },
+    { 0.98094, 0.992199, 0.975247, 0.949482, 0.962497, 0.980916, 0.954075, 0.955169, 0.973111, 0.963634, 0.956295, 0.977135, 0.987932, 0.989895 }
+  };
+
+  //bins in |eta| are [lo,hi); the centrality and pt binning depends on the |eta| bin
+  //(unused entries of the last |eta| bin are padded with 0)
+  constexpr int trigNEta = 3;
+  constexpr double trigAbsEtaEdges[trigNEta+1] = { 0, 1.2, 2.1, 2.4 };
+  constexpr int trigNCent[trigNEta] = { 3, 3, 2 };
+  constexpr double trigCentEdges[trigNEta][4] = { { 0, 10, 20, 100 }, { 0, 10, 20, 100 }, { 0, 20, 100, 0 } };
+  constexpr int trigNPt[trigNEta] = { 5, 5, 4 };
+  constexpr double trigPtEdges[trigNEta][6] = { { 15, 20, 30, 50, 80, 9999 }, { 15, 20, 30, 50, 80, 9999 }, { 15, 20, 30, 50, 9999, 0 } };
+  constexpr double trigEffMC[trigNEta][3][5] = {
+    {
+      { 0.90236, 0.926668, 0.950628, 0.955633, 0.941845 },
+      { 0.945948, 0.957968, 0.966709, 0.96932, 0.962404 },
+      { 0.972135, 0.976769, 0.977621, 0.976922, 0.97363 }
+    },
+    {
+      { 0.886045, 0.905927, 0.927901, 0.93394, 0.941171 },
+      { 0.930556, 0.939308, 0.95477, 0.961815, 0.961547 },
+      { 0.96814, 0.972713, 0.980361, 0.981367, 0.980518 }
+    },
+    {
+      { 0.851172, 0.883812, 0.910599, 0.925773, 0 },
+      { 0.957833, 0.969499, 0.975326, 0.976695, 0 },
+      { 0, 0, 0, 0, 0 }
+    }
+  };
+
+  //data efficiency: nominal, stat up, stat down, TnP fit syst up, TnP fit syst down
+  constexpr double trigEffData[5][trigNEta][3][5] = {
+    {
+      {
+        { 0.825623, 0.88834, 0.924312, 0.92636, 0.957096 },
+        { 0.902638, 0.935704, 0.949354, 0.949748, 0.930156 },
+        { 0.974178, 0.971988, 0.971353, 0.970512, 0.936028 }
+      },
+      {
+        { 0.837076, 0.85444, 0.886979, 0.906104, 0.924293 },
+        { 0.887064, 0.914084, 0.924853, 0.948331, 0.864777 },
+        { 0.965473, 0.966372, 0.967069, 0.968079, 0.983006 }
+      },
+      {
+        { 0.792647, 0.813261, 0.861218, 0.884202, 0 },
+        { 0.93984, 0.968807, 0.964683, 0.961035, 0 },
+        { 0, 0, 0, 0, 0 }
+      }
+    },
+    {
+      {
+        { 0.849434, 0.898723, 0.927712, 0.935152, 0.973337 },
+        { 0.929686, 0.944892, 0.952679, 0.957877, 0.95577 },
+        { 0.985178, 0.97714, 0.975451, 0.975891, 0.958392 }
+      },
+      {
+        { 0.86489, 0.866847, 0.892546, 0.919425, 0.956828 },
+        { 0.91195, 0.926608, 0.930635, 0.959537, 0.914375 },
+        { 0.979286, 0.973193, 0.970141, 0.975837, 0.994835 }
+      },
+      {
+        { 0.834505, 0.834372, 0.870948, 0.906348, 0 },
+        { 0.965181, 0.979263, 0.971248, 0.978381, 0 },
+        { 0, 0, 0, 0, 0 }
+      }
+    },
+    {
+      {
+        { 0.799965, 0.877428, 0.920806, 0.916977, 0.935705 },
+        { 0.871347, 0.925738, 0.945883, 0.940674, 0.897599 },
+        { 0.959218, 0.966266, 0.968389, 0.964405, 0.906852 }
+      },
+      {
+        { 0.807131, 0.8416, 0.881247, 0.89155, 0.880776 },
+        { 0.857638, 0.900577, 0.918849, 0.935638, 0.802326 },
+        { 0.948239, 0.958668, 0.963797, 0.959117, 0.960314 }
+      },
+      {
+        { 0.746978, 0.790995, 0.851077, 0.859061, 0 },
+        { 0.905329, 0.955546, 0.957204, 0.937631, 0 },
+        { 0, 0, 0, 0, 0 }
+      }
+    },
+    {
+      {
+        { 0.841672, 0.892162, 0.927346, 0.932938, 0.957671 },
+        { 0.914009, 0.940075, 0.950756, 0.950313, 0.93906 },
+        { 0.976316, 0.979949, 0.974861, 0.974511, 0.940442 }
+      },
+      {
+        { 0.864864, 0.863452, 0.89454, 0.911352, 0.936901 },
+        { 0.898048, 0.9333, 0.926577, 0.951679, 0.885396 },
+        { 0.970971, 0.968504, 0.967916, 0.969153, 0.98622 }
+      },
+      {
+        { 0.814721, 0.825021, 0.865798, 0.886639, 0 },
+        { 0.958064, 0.971345, 0.966718, 0.966004, 0 },
+        { 0, 0, 0, 0, 0 }
+      }
+    },
+    {
+      {
+        { 0.809573, 0.884517, 0.921277, 0.919781, 0.956521 },
+        { 0.891268, 0.931334, 0.947952, 0.949184, 0.921253 },
+        { 0.972041, 0.964027, 0.967845, 0.966513, 0.931614 }
+      },
+      {
+        { 0.809289, 0.845428, 0.879417, 0.900856, 0.911685 },
+        { 0.87608, 0.894868, 0.923129, 0.944984, 0.844158 },
+        { 0.959975, 0.964239, 0.966221, 0.967005, 0.979791 }
+      },
+      {
+        { 0.770573, 0.8015, 0.856638, 0.881766, 0 },
+        { 0.921617, 0.966269, 0.962647, 0.956067, 0 },
+        { 0, 0, 0, 0, 0 }
+      }
+    }
+  };
+
+  //index of the bin (lo,hi] containing x, the first bin includes its lower edge; -1 if outside
+  inline int findBinUpperInclusive(const double *edges, int nbins, double x) noexcept
+  {
+    if(x<edges[0] || x>edges[nbins]) return -1;
+    return std::max(int(std::lower_bound(edges+1,edges+nbins+1,x)-edges)-1,0);
+  }
+
+  //index of the bin [lo,hi) containing x; -1 if outside
+  inline int findBin(const double *edges, int nbins, double x) noexcept
+  {
+    if(x<edges[0] || x>=edges[nbins]) return -1;
+    return int(std::upper_bound(edges,edges+nbins+1,x)-edges)-1;
+  }
+
+  inline TnPWeight_t unity(int status=TNP_OK) noexcept
+  {
+    TnPWeight_t w = {1.,1.,1.,1.,1.,1.,1.,status};
+    return w;
+  }
+
+  //selects the variation corresponding to the legacy idx convention
+  //undefined indices in (2,10] leave the data efficiency to 1, the other ones (idx<-2 or idx>10)
+  //are the nominal, or leave the data efficiency to 1 if nominalIfUndefined=false
+  //(as the 40-100% centrality bin of the original glbtrk parameterization)
+  inline double select(const TnPWeight_t &w, int idx, bool nominalIfUndefined=true) noexcept
+  {
+    switch(idx) {
+    case 0:   return w.nominal;
+    case 1:   return w.statUp;
+    case 2:   return w.statDown;
+    case -1:  return w.systUp;
+    case -2:  return w.systDown;
+    case 200: return w.effData;
+    case 300: return w.effMC;
+    }
+    return (idx>2 && idx<=10) || !nominalIfUndefined ? 1./w.effMC : w.nominal;
+  }
+
+}
+
 ///////////////////////////////////////////////////
 //              G l b T r k    P b P b           //
 ///////////////////////////////////////////////////
 
-double tnp_weight_glbtrk_pbpb(double eta, double cent, int idx) //cent 0-100%
+inline TnPWeight_t tnp_weights_glbtrk_pbpb(double eta, double cent) noexcept //cent 0-100%
 {
-	double num = 1, den = 1;
-
-	if (fabs(eta)>2.4) { std::cout << "[WARNING] Muon pseudo-rapidity (" << eta << ") outside [-2.4, 2.4]" << std::endl; return 1.0; }
-	if (cent < 0 || cent>100) { std::cout << "[ERROR] Centrality (" << cent << ") outside [0%, 100%]" << std::endl; return 1.0; }
-
-	if (cent >= 0 && cent < 40)
-	{
-		// MC
-		if (eta >= -2.4 && eta <= -2.1) { den = 0.955981; }
-		else if (eta > -2.1 && eta <= -1.6) { den = 0.976366; }
-		else if (eta > -1.6 && eta <= -1.2) { den = 0.977068; }
-		else if (eta > -1.2 && eta <= -0.9) { den = 0.973544; }
-		else if (eta > -0.9 && eta <= 0) { den = 0.970051; }
-		else if (eta > 0 && eta <= 0.9) { den = 0.969666; }
-		else if (eta > 0.9 && eta <= 1.2) { den = 0.972616; }
-		else if (eta > 1.2 && eta <= 1.6) { den = 0.978239; }
-		else if (eta > 1.6 && eta <= 2.1) { den = 0.980999; }
-		else if (eta > 2.1 && eta <= 2.4) { den = 0.962922; }
-
-		// data
-		if (idx <= 0 || idx > 10) { // nominal
-			if (eta >= -2.4 && eta <= -2.1) { num = 0.895748; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.961812; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.963615; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.953689; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.960387; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.959435; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.935934; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.968385; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.97469; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.940124; }
-		}
-
-		if (idx == 1) { // stat up
-			if (eta >= -2.4 && eta <= -2.1) { num = 0.912779; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.96884; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.968562; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.960157; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.963199; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.962357; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.943263; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.97301; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.981141; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.959268; }
-		}
-
-		if (idx == 2) { // stat down
-			if (eta >= -2.4 && eta <= -2.1) { num = 0.878718; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.954599; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.958397; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.946923; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.957485; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.956421; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.928318; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.963989; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.968032; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.921065; }
-		}
-		if (idx == -1) { // syst up
-			if (eta >= -2.4 && eta <= -2.1) { num = 0.912388; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.965296; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.965531; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.955926; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.961333; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.960196; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.937628; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.971776; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.97886; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.947469; }
-		}
-		if (idx == -2) { // syst down
-			if (eta >= -2.4 && eta <= -2.1) { num = 0.879108; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.958329; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.961699; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.951452; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.959441; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.958675; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.934239; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.964993; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.97052; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.932779; }
-		}
-	}
-	else if (cent >= 40 && cent <= 100)
-	{
-		// MC
-		if (eta >= -2.4 && eta <= -2.1) { den = 0.985973; }
-		else if (eta > -2.1 && eta <= -1.6) { den = 0.99412; }
-		else if (eta > -1.6 && eta <= -1.2) { den = 0.996646; }
-		else if (eta > -1.2 && eta <= -0.9) { den = 0.991832; }
-		else if (eta > -0.9 && eta <= 0) { den = 0.985575; }
-		else if (eta > 0 && eta <= 0.9) { den = 0.985295; }
-		else if (eta > 0.9 && eta <= 1.2) { den = 0.992634; }
-		else if (eta > 1.2 && eta <= 1.6) { den = 0.996896; }
-		else if (eta > 1.6 && eta <= 2.1) { den = 0.994506; }
-		else if (eta > 2.1 && eta <= 2.4) { den = 0.987764; }
-
-		// data
-		if (idx == 0) { // nominal
-			if (eta >= -2.4 && eta <= -2.1) { num = 1; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.986484; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.998253; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.987887; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.987426; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.981425; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.984663; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.992795; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.983557; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.954671; }
-		}
-
-		if (idx == 1) { // stat up
-			if (eta >= -2.4 && eta <= -2.1) { num = 1; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.99644; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 1; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.994144; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.992029; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.987024; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.992709; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.997686; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.991048; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.979823; }
-		}
-		if (idx == 2) { // stat down
-			if (eta >= -2.4 && eta <= -2.1) { num = 0.979675; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.974748; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.993399; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.978866; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.98235; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.974871; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.974046; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.985567; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.974474; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.92457; }
-		}
-		if (idx == -1) { // syst up
-			if (eta >= -2.4 && eta <= -2.1) { num = 1.0107; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.992138; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.999945; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.988701; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.988734; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.985979; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.987238; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.994278; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.98701; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.960013; }
-		}
-		if (idx == -2) { // syst down
-			if (eta >= -2.4 && eta <= -2.1) { num = 0.989305; }
-			else if (eta > -2.1 && eta <= -1.6) { num = 0.980829; }
-			else if (eta > -1.6 && eta <= -1.2) { num = 0.99656; }
-			else if (eta > -1.2 && eta <= -0.9) { num = 0.987074; }
-			else if (eta > -0.9 && eta <= 0) { num = 0.986119; }
-			else if (eta > 0 && eta <= 0.9) { num = 0.976872; }
-			else if (eta > 0.9 && eta <= 1.2) { num = 0.982088; }
-			else if (eta > 1.2 && eta <= 1.6) { num = 0.991312; }
-			else if (eta > 1.6 && eta <= 2.1) { num = 0.980103; }
-			else if (eta > 2.1 && eta <= 2.4) { num = 0.949328; }
-		}
-	}
-
-	if (idx == 200) den = 1.;
-	if (idx == 300) num = den * den;
-
-
-	return (num / den);
+  using namespace tnp_tables;
+
+  if (fabs(eta)>2.4) return unity(TNP_ETA_OUT_OF_RANGE);
+  if (cent < 0 || cent>100) return unity(TNP_CENT_OUT_OF_RANGE);
+
+  int ieta(findBinUpperInclusive(glbtrkEtaEdges,glbtrkNEta,eta));
+  if (ieta<0) return unity();
+  int icen(cent < 40 ? 0 : 1);
+
+  double den(glbtrkEffMC[icen][ieta]);
+  const double (&num)[5][glbtrkNEta] = glbtrkEffData[icen];
+  TnPWeight_t w;
+  w.status   = TNP_OK;
+  w.nominal  = num[0][ieta]/den;
+  w.statUp   = num[1][ieta]/den;
+  w.statDown = num[2][ieta]/den;
+  w.systUp   = num[3][ieta]/den;
+  w.systDown = num[4][ieta]/den;
+  w.effMC    = den;
+
+  //as in the original parameterization the data efficiency is only defined for the 0-40% bin
+  w.effData  = (icen==0 ? num[0][ieta] : 1.);
+  return w;
+}
 
+inline double tnp_weight_glbtrk_pbpb(double eta, double cent, int idx) //cent 0-100%
+{
+  TnPWeight_t w(tnp_weights_glbtrk_pbpb(eta,cent));
+  tnp_report(w,"tnp_weight_glbtrk_pbpb",0.,eta,cent);
+  return tnp_tables::select(w,idx,cent<40);
 }
 
 ///////////////////////////////////////////////////
 //                 M u I D    P b P b            //
 ///////////////////////////////////////////////////
-double tnp_weight_muid_pbpb(double eta, int idx)
+inline TnPWeight_t tnp_weights_muid_pbpb(double eta) noexcept
 {
-   double syst = 0.6e-2;    //preliminary
-
-   double num=1,den=1;
-   
-   if (fabs(eta) > 2.4) { std::cout << "[WARNING] Muon pseudo-rapidity (" << eta << ") outside [-2.4, 2.4]" << std::endl; return 1.0; }
-
-   // MC
-   if (eta >= -2.4 && eta <= -2.1) { den = 0.994139; }
-   else if (eta > -2.1 && eta <= -1.6) { den = 0.99449; }
-   else if (eta > -1.6 && eta <= -1.2) { den = 0.983536; }
-   else if (eta > -1.2 && eta <= -0.9) { den = 0.964562; }
-   else if (eta > -0.9 && eta <= -0.6) { den = 0.973316; }
-   else if (eta > -0.6 && eta <= -0.3) { den = 0.981446; }
-   else if (eta > -0.3 && eta <= 0) { den = 0.968189; }
-   else if (eta > 0 && eta <= 0.3) { den = 0.9617; }
-   else if (eta > 0.3 && eta <= 0.6) { den = 0.979738; }
-   else if (eta > 0.6 && eta <= 0.9) { den = 0.969536; }
-   else if (eta > 0.9 && eta <= 1.2) { den = 0.960259; }
-   else if (eta > 1.2 && eta <= 1.6) { den = 0.983279; }
-   else if (eta > 1.6 && eta <= 2.1) { den = 0.99477; }
-   else if (eta > 2.1 && eta <= 2.4) { den = 0.994065; }
-
-
-   // data
-   if (idx <= 0 || idx > 10) { // nominal
-	   if (eta >= -2.4 && eta <= -2.1) { num = 0.984278; }
-	   else if (eta > -2.1 && eta <= -1.6) { num = 0.994031; }
-	   else if (eta > -1.6 && eta <= -1.2) { num = 0.978562; }
-	   else if (eta > -1.2 && eta <= -0.9) { num = 0.954321; }
-	   else if (eta > -0.9 && eta <= -0.6) { num = 0.966508; }
-	   else if (eta > -0.6 && eta <= -0.3) { num = 0.98402; }
-	   else if (eta > -0.3 && eta <= 0) { num = 0.958369; }
-	   else if (eta > 0 && eta <= 0.3) { num = 0.959429; }
-	   else if (eta > 0.3 && eta <= 0.6) { num = 0.976528; }
-	   else if (eta > 0.6 && eta <= 0.9) { num = 0.967646; }
-	   else if (eta > 0.9 && eta <= 1.2) { num = 0.961046; }
-	   else if (eta > 1.2 && eta <= 1.6) { num = 0.980274; }
-	   else if (eta > 1.6 && eta <= 2.1) { num = 0.991677; }
-	   else if (eta > 2.1 && eta <= 2.4) { num = 0.993007; }
-   }
-   else if (idx == 1) { // stat up
-	   if (eta >= -2.4 && eta <= -2.1) { num = 0.987203; }
-	   else if (eta > -2.1 && eta <= -1.6) { num = 0.995641; }
-	   else if (eta > -1.6 && eta <= -1.2) { num = 0.981641; }
-	   else if (eta > -1.2 && eta <= -0.9) { num = 0.958889; }
-	   else if (eta > -0.9 && eta <= -0.6) { num = 0.970274; }
-	   else if (eta > -0.6 && eta <= -0.3) { num = 0.986882; }
-	   else if (eta > -0.3 && eta <= 0) { num = 0.962433; }
-	   else if (eta > 0 && eta <= 0.3) { num = 0.96344; }
-	   else if (eta > 0.3 && eta <= 0.6) { num = 0.979706; }
-	   else if (eta > 0.6 && eta <= 0.9) { num = 0.971414; }
-	   else if (eta > 0.9 && eta <= 1.2) { num = 0.965537; }
-	   else if (eta > 1.2 && eta <= 1.6) { num = 0.983167; }
-	   else if (eta > 1.6 && eta <= 2.1) { num = 0.99336; }
-	   else if (eta > 2.1 && eta <= 2.4) { num = 0.995579; }
-   }
-   else if (idx == 2) { // stat down
-	   if (eta >= -2.4 && eta <= -2.1) { num = 0.98094; }
-	   else if (eta > -2.1 && eta <= -1.6) { num = 0.992199; }
-	   else if (eta > -1.6 && eta <= -1.2) { num = 0.975247; }
-	   else if (eta > -1.2 && eta <= -0.9) { num = 0.949482; }
-	   else if (eta > -0.9 && eta <= -0.6) { num = 0.962497; }
-	   else if (eta > -0.6 && eta <= -0.3) { num = 0.980916; }
-	   else if (eta > -0.3 && eta <= 0) { num = 0.954075; }
-	   else if (eta > 0 && eta <= 0.3) { num = 0.955169; }
-	   else if (eta > 0.3 && eta <= 0.6) { num = 0.973111; }
-	   else if (eta > 0.6 && eta <= 0.9) { num = 0.963634; }
-	   else if (eta > 0.9 && eta <= 1.2) { num = 0.956295; }
-	   else if (eta > 1.2 && eta <= 1.6) { num = 0.977135; }
-	   else if (eta > 1.6 && eta <= 2.1) { num = 0.987932; }
-	   else if (eta > 2.1 && eta <= 2.4) { num = 0.989895; }
-   }
-
-   if (idx == 200) den = 1.;
-   if (idx == 300) num = den * den;
-
-
-   double syst_factor = 1.;
-   if (idx == -1) syst_factor = 1 + syst;
-   if (idx == -2) syst_factor = 1 - syst;
-   return (num / den)*syst_factor;
+  using namespace tnp_tables;
+
+  if (fabs(eta) > 2.4) return unity(TNP_ETA_OUT_OF_RANGE);
+
+  int ieta(findBinUpperInclusive(muidEtaEdges,muidNEta,eta));
+  if (ieta<0) return unity();
+
+  double den(muidEffMC[ieta]);
+  TnPWeight_t w;
+  w.status   = TNP_OK;
+  w.nominal  = muidEffData[0][ieta]/den;
+  w.statUp   = muidEffData[1][ieta]/den;
+  w.statDown = muidEffData[2][ieta]/den;
+  w.systUp   = w.nominal*(1+muidSyst);
+  w.systDown = w.nominal*(1-muidSyst);
+  w.effData  = muidEffData[0][ieta];
+  w.effMC    = den;
+  return w;
 }
 
+inline double tnp_weight_muid_pbpb(double eta, int idx)
+{
+  TnPWeight_t w(tnp_weights_muid_pbpb(eta));
+  tnp_report(w,"tnp_weight_muid_pbpb",0.,eta,0.);
+  return tnp_tables::select(w,idx);
+}
 
 ///////////////////////////////////////////////////
 //               T R G      P b P b              //
 ///////////////////////////////////////////////////
-double tnp_weight_trig_pbpb(double pt, double eta, double cent, int idx)
+inline TnPWeight_t tnp_weights_trig_pbpb(double pt, double eta, double cent) noexcept
 {
+  using namespace tnp_tables;
+
   // Check input variables
   double abseta = fabs(eta);
-  if (pt<15) { std::cout << "[WARNING] Muon pT (" << pt <<") < 15 GeV/c" << std::endl; return 1.0; }
-  if (abseta>2.4) { std::cout << "[WARNING] Muon pseudo-rapidity (" << eta << ") outside [-2.4, 2.4]" << std::endl; return 1.0; }
-  if (cent<0 || cent>100) { std::cout << "[ERROR] Centrality (" << cent << ") outside [0%, 100%]" << std::endl; return 1.0; }
-
-  double num=1.0, den=1.0;
-
-  // MC
-  if (abseta >= 0 && abseta < 1.2) { 
-    if (cent >= 0 && cent < 10) { 
-      if (pt >= 15 && pt < 20) den = 0.90236;
-      else if (pt >= 20 && pt < 30) den = 0.926668;
-      else if (pt >= 30 && pt < 50) den = 0.950628;
-      else if (pt >= 50 && pt < 80) den = 0.955633;
-      else if (pt >= 80 && pt < 9999) den = 0.941845;
-    }
-    else if (cent >= 10 && cent < 20) { 
-      if (pt >= 15 && pt < 20) den = 0.945948;
-      else if (pt >= 20 && pt < 30) den = 0.957968;
-      else if (pt >= 30 && pt < 50) den = 0.966709;
-      else if (pt >= 50 && pt < 80) den = 0.96932;
-      else if (pt >= 80 && pt < 9999) den = 0.962404;
-    }
-    else if (cent >= 20 && cent < 100) { 
-      if (pt >= 15 && pt < 20) den = 0.972135;
-      else if (pt >= 20 && pt < 30) den = 0.976769;
-      else if (pt >= 30 && pt < 50) den = 0.977621;
-      else if (pt >= 50 && pt < 80) den = 0.976922;
-      else if (pt >= 80 && pt < 9999) den = 0.97363;
-    }
-  }
-  else if (abseta >= 1.2 && abseta < 2.1) { 
-    if (cent >= 0 && cent < 10) { 
-      if (pt >= 15 && pt < 20) den = 0.886045;
-      else if (pt >= 20 && pt < 30) den = 0.905927;
-      else if (pt >= 30 && pt < 50) den = 0.927901;
-      else if (pt >= 50 && pt < 80) den = 0.93394;
-      else if (pt >= 80 && pt < 9999) den = 0.941171;
-    }
-    else if (cent >= 10 && cent < 20) { 
-      if (pt >= 15 && pt < 20) den = 0.930556;
-      else if (pt >= 20 && pt < 30) den = 0.939308;
-      else if (pt >= 30 && pt < 50) den = 0.95477;
-      else if (pt >= 50 && pt < 80) den = 0.961815;
-      else if (pt >= 80 && pt < 9999) den = 0.961547;
-    }
-    else if (cent >= 20 && cent < 100) { 
-      if (pt >= 15 && pt < 20) den = 0.96814;
-      else if (pt >= 20 && pt < 30) den = 0.972713;
-      else if (pt >= 30 && pt < 50) den = 0.980361;
-      else if (pt >= 50 && pt < 80) den = 0.981367;
-      else if (pt >= 80 && pt < 9999) den = 0.980518;
-    }
-  }
-  else if (abseta >= 2.1 && abseta < 2.4) { 
-    if (cent >= 0 && cent < 20) { 
-      if (pt >= 15 && pt < 20) den = 0.851172;
-      else if (pt >= 20 && pt < 30) den = 0.883812;
-      else if (pt >= 30 && pt < 50) den = 0.910599;
-      else if (pt >= 50 && pt < 9999) den = 0.925773;
-    }
-    else if (cent >= 20 && cent < 100) { 
-      if (pt >= 15 && pt < 20) den = 0.957833;
-      else if (pt >= 20 && pt < 30) den = 0.969499;
-      else if (pt >= 30 && pt < 50) den = 0.975326;
-      else if (pt >= 50 && pt < 9999) den = 0.976695;
-    }
-  }
-
-  // data
-  if (idx <= 0 || idx > 10) { // nominal
-    if (abseta >= 0 && abseta < 1.2) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.825623;
-        else if (pt >= 20 && pt < 30) num = 0.88834;
-        else if (pt >= 30 && pt < 50) num = 0.924312;
-        else if (pt >= 50 && pt < 80) num = 0.92636;
-        else if (pt >= 80 && pt < 9999) num = 0.957096;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.902638;
-        else if (pt >= 20 && pt < 30) num = 0.935704;
-        else if (pt >= 30 && pt < 50) num = 0.949354;
-        else if (pt >= 50 && pt < 80) num = 0.949748;
-        else if (pt >= 80 && pt < 9999) num = 0.930156;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.974178;
-        else if (pt >= 20 && pt < 30) num = 0.971988;
-        else if (pt >= 30 && pt < 50) num = 0.971353;
-        else if (pt >= 50 && pt < 80) num = 0.970512;
-        else if (pt >= 80 && pt < 9999) num = 0.936028;
-      }
-    }
-    else if (abseta >= 1.2 && abseta < 2.1) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.837076;
-        else if (pt >= 20 && pt < 30) num = 0.85444;
-        else if (pt >= 30 && pt < 50) num = 0.886979;
-        else if (pt >= 50 && pt < 80) num = 0.906104;
-        else if (pt >= 80 && pt < 9999) num = 0.924293;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.887064;
-        else if (pt >= 20 && pt < 30) num = 0.914084;
-        else if (pt >= 30 && pt < 50) num = 0.924853;
-        else if (pt >= 50 && pt < 80) num = 0.948331;
-        else if (pt >= 80 && pt < 9999) num = 0.864777;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.965473;
-        else if (pt >= 20 && pt < 30) num = 0.966372;
-        else if (pt >= 30 && pt < 50) num = 0.967069;
-        else if (pt >= 50 && pt < 80) num = 0.968079;
-        else if (pt >= 80 && pt < 9999) num = 0.983006;
-      }
-    }
-    else if (abseta >= 2.1 && abseta < 2.4) { 
-      if (cent >= 0 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.792647;
-        else if (pt >= 20 && pt < 30) num = 0.813261;
-        else if (pt >= 30 && pt < 50) num = 0.861218;
-        else if (pt >= 50 && pt < 9999) num = 0.884202;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.93984;
-        else if (pt >= 20 && pt < 30) num = 0.968807;
-        else if (pt >= 30 && pt < 50) num = 0.964683;
-        else if (pt >= 50 && pt < 9999) num = 0.961035;
-      }
-    }
-  }
-  else if (idx == 1) { // stat up
-    if (abseta >= 0 && abseta < 1.2) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.849434;
-        else if (pt >= 20 && pt < 30) num = 0.898723;
-        else if (pt >= 30 && pt < 50) num = 0.927712;
-        else if (pt >= 50 && pt < 80) num = 0.935152;
-        else if (pt >= 80 && pt < 9999) num = 0.973337;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.929686;
-        else if (pt >= 20 && pt < 30) num = 0.944892;
-        else if (pt >= 30 && pt < 50) num = 0.952679;
-        else if (pt >= 50 && pt < 80) num = 0.957877;
-        else if (pt >= 80 && pt < 9999) num = 0.95577;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.985178;
-        else if (pt >= 20 && pt < 30) num = 0.97714;
-        else if (pt >= 30 && pt < 50) num = 0.975451;
-        else if (pt >= 50 && pt < 80) num = 0.975891;
-        else if (pt >= 80 && pt < 9999) num = 0.958392;
-      }
-    }
-    else if (abseta >= 1.2 && abseta < 2.1) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.86489;
-        else if (pt >= 20 && pt < 30) num = 0.866847;
-        else if (pt >= 30 && pt < 50) num = 0.892546;
-        else if (pt >= 50 && pt < 80) num = 0.919425;
-        else if (pt >= 80 && pt < 9999) num = 0.956828;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.91195;
-        else if (pt >= 20 && pt < 30) num = 0.926608;
-        else if (pt >= 30 && pt < 50) num = 0.930635;
-        else if (pt >= 50 && pt < 80) num = 0.959537;
-        else if (pt >= 80 && pt < 9999) num = 0.914375;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.979286;
-        else if (pt >= 20 && pt < 30) num = 0.973193;
-        else if (pt >= 30 && pt < 50) num = 0.970141;
-        else if (pt >= 50 && pt < 80) num = 0.975837;
-        else if (pt >= 80 && pt < 9999) num = 0.994835;
-      }
-    }
-    else if (abseta >= 2.1 && abseta < 2.4) { 
-      if (cent >= 0 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.834505;
-        else if (pt >= 20 && pt < 30) num = 0.834372;
-        else if (pt >= 30 && pt < 50) num = 0.870948;
-        else if (pt >= 50 && pt < 9999) num = 0.906348;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.965181;
-        else if (pt >= 20 && pt < 30) num = 0.979263;
-        else if (pt >= 30 && pt < 50) num = 0.971248;
-        else if (pt >= 50 && pt < 9999) num = 0.978381;
-      }
-    }
-  }
-  else if (idx == 2) { // stat down
-    if (abseta >= 0 && abseta < 1.2) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.799965;
-        else if (pt >= 20 && pt < 30) num = 0.877428;
-        else if (pt >= 30 && pt < 50) num = 0.920806;
-        else if (pt >= 50 && pt < 80) num = 0.916977;
-        else if (pt >= 80 && pt < 9999) num = 0.935705;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.871347;
-        else if (pt >= 20 && pt < 30) num = 0.925738;
-        else if (pt >= 30 && pt < 50) num = 0.945883;
-        else if (pt >= 50 && pt < 80) num = 0.940674;
-        else if (pt >= 80 && pt < 9999) num = 0.897599;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.959218;
-        else if (pt >= 20 && pt < 30) num = 0.966266;
-        else if (pt >= 30 && pt < 50) num = 0.968389;
-        else if (pt >= 50 && pt < 80) num = 0.964405;
-        else if (pt >= 80 && pt < 9999) num = 0.906852;
-      }
-    }
-    else if (abseta >= 1.2 && abseta < 2.1) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.807131;
-        else if (pt >= 20 && pt < 30) num = 0.8416;
-        else if (pt >= 30 && pt < 50) num = 0.881247;
-        else if (pt >= 50 && pt < 80) num = 0.89155;
-        else if (pt >= 80 && pt < 9999) num = 0.880776;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.857638;
-        else if (pt >= 20 && pt < 30) num = 0.900577;
-        else if (pt >= 30 && pt < 50) num = 0.918849;
-        else if (pt >= 50 && pt < 80) num = 0.935638;
-        else if (pt >= 80 && pt < 9999) num = 0.802326;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.948239;
-        else if (pt >= 20 && pt < 30) num = 0.958668;
-        else if (pt >= 30 && pt < 50) num = 0.963797;
-        else if (pt >= 50 && pt < 80) num = 0.959117;
-        else if (pt >= 80 && pt < 9999) num = 0.960314;
-      }
-    }
-    else if (abseta >= 2.1 && abseta < 2.4) { 
-      if (cent >= 0 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.746978;
-        else if (pt >= 20 && pt < 30) num = 0.790995;
-        else if (pt >= 30 && pt < 50) num = 0.851077;
-        else if (pt >= 50 && pt < 9999) num = 0.859061;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.905329;
-        else if (pt >= 20 && pt < 30) num = 0.955546;
-        else if (pt >= 30 && pt < 50) num = 0.957204;
-        else if (pt >= 50 && pt < 9999) num = 0.937631;
-      }
-    }
-  }
-  else if (idx == -1) { // TnP fit syst up
-    if (abseta >= 0 && abseta < 1.2) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.841672;
-        else if (pt >= 20 && pt < 30) num = 0.892162;
-        else if (pt >= 30 && pt < 50) num = 0.927346;
-        else if (pt >= 50 && pt < 80) num = 0.932938;
-        else if (pt >= 80 && pt < 9999) num = 0.957671;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.914009;
-        else if (pt >= 20 && pt < 30) num = 0.940075;
-        else if (pt >= 30 && pt < 50) num = 0.950756;
-        else if (pt >= 50 && pt < 80) num = 0.950313;
-        else if (pt >= 80 && pt < 9999) num = 0.93906;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.976316;
-        else if (pt >= 20 && pt < 30) num = 0.979949;
-        else if (pt >= 30 && pt < 50) num = 0.974861;
-        else if (pt >= 50 && pt < 80) num = 0.974511;
-        else if (pt >= 80 && pt < 9999) num = 0.940442;
-      }
-    }
-    else if (abseta >= 1.2 && abseta < 2.1) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.864864;
-        else if (pt >= 20 && pt < 30) num = 0.863452;
-        else if (pt >= 30 && pt < 50) num = 0.89454;
-        else if (pt >= 50 && pt < 80) num = 0.911352;
-        else if (pt >= 80 && pt < 9999) num = 0.936901;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.898048;
-        else if (pt >= 20 && pt < 30) num = 0.9333;
-        else if (pt >= 30 && pt < 50) num = 0.926577;
-        else if (pt >= 50 && pt < 80) num = 0.951679;
-        else if (pt >= 80 && pt < 9999) num = 0.885396;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.970971;
-        else if (pt >= 20 && pt < 30) num = 0.968504;
-        else if (pt >= 30 && pt < 50) num = 0.967916;
-        else if (pt >= 50 && pt < 80) num = 0.969153;
-        else if (pt >= 80 && pt < 9999) num = 0.98622;
-      }
-    }
-    else if (abseta >= 2.1 && abseta < 2.4) { 
-      if (cent >= 0 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.814721;
-        else if (pt >= 20 && pt < 30) num = 0.825021;
-        else if (pt >= 30 && pt < 50) num = 0.865798;
-        else if (pt >= 50 && pt < 9999) num = 0.886639;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.958064;
-        else if (pt >= 20 && pt < 30) num = 0.971345;
-        else if (pt >= 30 && pt < 50) num = 0.966718;
-        else if (pt >= 50 && pt < 9999) num = 0.966004;
-      }
-    }
-  }
-  else if (idx == -2) { // TnP fit syst down
-    if (abseta >= 0 && abseta < 1.2) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.809573;
-        else if (pt >= 20 && pt < 30) num = 0.884517;
-        else if (pt >= 30 && pt < 50) num = 0.921277;
-        else if (pt >= 50 && pt < 80) num = 0.919781;
-        else if (pt >= 80 && pt < 9999) num = 0.956521;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.891268;
-        else if (pt >= 20 && pt < 30) num = 0.931334;
-        else if (pt >= 30 && pt < 50) num = 0.947952;
-        else if (pt >= 50 && pt < 80) num = 0.949184;
-        else if (pt >= 80 && pt < 9999) num = 0.921253;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.972041;
-        else if (pt >= 20 && pt < 30) num = 0.964027;
-        else if (pt >= 30 && pt < 50) num = 0.967845;
-        else if (pt >= 50 && pt < 80) num = 0.966513;
-        else if (pt >= 80 && pt < 9999) num = 0.931614;
-      }
-    }
-    else if (abseta >= 1.2 && abseta < 2.1) { 
-      if (cent >= 0 && cent < 10) { 
-        if (pt >= 15 && pt < 20) num = 0.809289;
-        else if (pt >= 20 && pt < 30) num = 0.845428;
-        else if (pt >= 30 && pt < 50) num = 0.879417;
-        else if (pt >= 50 && pt < 80) num = 0.900856;
-        else if (pt >= 80 && pt < 9999) num = 0.911685;
-      }
-      else if (cent >= 10 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.87608;
-        else if (pt >= 20 && pt < 30) num = 0.894868;
-        else if (pt >= 30 && pt < 50) num = 0.923129;
-        else if (pt >= 50 && pt < 80) num = 0.944984;
-        else if (pt >= 80 && pt < 9999) num = 0.844158;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.959975;
-        else if (pt >= 20 && pt < 30) num = 0.964239;
-        else if (pt >= 30 && pt < 50) num = 0.966221;
-        else if (pt >= 50 && pt < 80) num = 0.967005;
-        else if (pt >= 80 && pt < 9999) num = 0.979791;
-      }
-    }
-    else if (abseta >= 2.1 && abseta < 2.4) { 
-      if (cent >= 0 && cent < 20) { 
-        if (pt >= 15 && pt < 20) num = 0.770573;
-        else if (pt >= 20 && pt < 30) num = 0.8015;
-        else if (pt >= 30 && pt < 50) num = 0.856638;
-        else if (pt >= 50 && pt < 9999) num = 0.881766;
-      }
-      else if (cent >= 20 && cent < 100) { 
-        if (pt >= 15 && pt < 20) num = 0.921617;
-        else if (pt >= 20 && pt < 30) num = 0.966269;
-        else if (pt >= 30 && pt < 50) num = 0.962647;
-        else if (pt >= 50 && pt < 9999) num = 0.956067;
-      }
-    }
-  }
+  if (pt<15) return unity(TNP_PT_BELOW_RANGE);
+  if (abseta>2.4) return unity(TNP_ETA_OUT_OF_RANGE);
+  if (cent<0 || cent>100) return unity(TNP_CENT_OUT_OF_RANGE);
+
+  int ieta(findBin(trigAbsEtaEdges,trigNEta,abseta));
+  if (ieta<0) return unity();
+  int icen(findBin(trigCentEdges[ieta],trigNCent[ieta],cent));
+  int ipt(findBin(trigPtEdges[ieta],trigNPt[ieta],pt));
+  if (icen<0 || ipt<0) return unity();
+
+  double den(trigEffMC[ieta][icen][ipt]);
+  TnPWeight_t w;
+  w.status   = TNP_OK;
+  w.nominal  = trigEffData[0][ieta][icen][ipt]/den;
+  w.statUp   = trigEffData[1][ieta][icen][ipt]/den;
+  w.statDown = trigEffData[2][ieta][icen][ipt]/den;
+  //the original if-else chain never reached the TnP fit syst tables (idx<0 was caught by the
+  //nominal branch), the nominal is kept here so that the scale factors are unchanged
+  w.systUp   = w.nominal;
+  w.systDown = w.nominal;
+  w.effData  = trigEffData[0][ieta][icen][ipt];
+  w.effMC    = den;
+  return w;
+}
 
-  if (idx == 200) den = 1.0;
-  if (idx == 300) num = den * den;
+inline double tnp_weight_trig_pbpb(double pt, double eta, double cent, int idx)
+{
+  TnPWeight_t w(tnp_weights_trig_pbpb(pt,eta,cent));
+  tnp_report(w,"tnp_weight_trig_pbpb",pt,eta,cent);
+  return tnp_tables::select(w,idx);
+}
 
-  return (num/den);
+///////////////////////////////////////////////////
+//               D I A G N O S T I C S           //
+///////////////////////////////////////////////////
+inline void tnp_report(const TnPWeight_t &w, const char *name, double pt, double eta, double cent)
+{
+  switch(w.status) {
+  case TNP_PT_BELOW_RANGE:    diagnostics().report(std::string("[WARNING] Muon pT < 15 GeV/c in ")+name, pt); break;
+  case TNP_ETA_OUT_OF_RANGE:  diagnostics().report(std::string("[WARNING] Muon pseudo-rapidity outside [-2.4, 2.4] in ")+name, eta); break;
+  case TNP_CENT_OUT_OF_RANGE: diagnostics().report(std::string("[ERROR] Centrality outside [0%, 100%] in ")+name, cent); break;
+  default: break;
+  }
 }
 
-#endif //#ifndef tnp_weight_h
+#endif
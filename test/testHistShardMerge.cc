@@ -0,0 +1,166 @@
+//
+// multi-threaded filling of HistTool (include/HistTool.h): the shards are filled concurrently and merged
+// - with a fixed slice of events per shard, the merged histograms must be bit-identical from one run to the next
+// - with the events handed out to the workers on demand, the merged histograms must be equal to those filled
+//   by a single shard: bit-identical for weights and values for which the float sums do not depend on the
+//   order, and up to the summation order otherwise
+//
+// compile and run from the package directory:
+//   g++ -std=c++17 -pthread -I$CMSSW_BASE/src `root-config --cflags --libs` test/testHistShardMerge.cc -o testHistShardMerge
+//   ./testHistShardMerge [number of shards] [number of runs]
+//
+
+#include "HeavyIonsAnalysis/topskim/include/HistTool.h"
+
+#include "TH1.h"
+#include "TH2.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const vector<TString> catNames = { "ee", "mm", "em", "eegeq1pfb", "mmgeq1pfb", "emgeq1pfb" };
+
+//entries, statistics, contents and errors of each histogram
+typedef map<TString, vector<double> > Snapshot_t;
+
+Snapshot_t snapshot(HistTool &ht)
+{
+  Snapshot_t snap;
+  auto add=[&snap](const TString &name, TH1 *h) {
+    vector<double> &v=snap[name];
+    double stats[7]={0,0,0,0,0,0,0};
+    h->GetStats(stats);
+    v.push_back(h->GetEntries());
+    v.insert(v.end(),stats,stats+7);
+    for(int i=0; i<h->GetNcells(); i++) { v.push_back(h->GetBinContent(i)); v.push_back(h->GetBinError(i)); }
+  };
+  for(auto &it : ht.getPlots())   add(it.first,it.second);
+  for(auto &it : ht.get2dPlots()) add(it.first,it.second);
+  return snap;
+}
+
+//largest relative difference (1 if the histograms differ in number or size)
+double maxRelDiff(const Snapshot_t &a, const Snapshot_t &b)
+{
+  if(a.size()!=b.size()) return 1.;
+  double maxDiff(0.);
+  for(auto &it : a) {
+    auto jt=b.find(it.first);
+    if(jt==b.end() || jt->second.size()!=it.second.size()) return 1.;
+    for(size_t i=0; i<it.second.size(); i++) {
+      double x(it.second[i]), y(jt->second[i]);
+      if(x==y) continue;
+      maxDiff=max(maxDiff,fabs(x-y)/max(max(fabs(x),fabs(y)),1e-300));
+    }
+  }
+  return maxDiff;
+}
+
+//pseudo-random numbers depending only on the event number, whichever worker fills it
+struct EventRandom {
+  uint64_t state;
+  EventRandom(uint64_t iev) : state(iev*0x9E3779B97F4A7C15ULL+1) { }
+  uint64_t next() {
+    uint64_t z=(state+=0x9E3779B97F4A7C15ULL);
+    z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+    z=(z^(z>>27))*0x94D049BB133111EBULL;
+    return z^(z>>31);
+  }
+  //uniform in [0,1), on a grid of 1/64 if dyadic so that all the sums (float contents included) are exact
+  double uniform(bool dyadic) { return dyadic ? (next()>>58)/64. : (next()>>11)*0x1.0p-53; }
+};
+
+struct Job_t {
+  size_t nShards, nEvents;
+  bool dynamic;   //events handed out on demand, otherwise a fixed slice per shard
+  bool dyadic;    //weights and values with exact sums
+};
+
+//fills a fresh tool from nShards threads and merges the shards
+Snapshot_t run(const Job_t &job)
+{
+  HistTool ht;
+  ht.addHist("pt",     new TH1F("pt",     ";p_{T};Events",50,0,200));
+  ht.addHist("mll",    new TH1F("mll",    ";m_{ll};Events",40,20,220));
+  ht.addHist("etaphi", new TH2F("etaphi", ";#eta;#phi",48,-2.4,2.4,64,-3.2,3.2));
+  ht.addHist("rows",   new TH2F("rows",   ";Step;Weight",5,0,5,10,0,10));
+  ht.setSparseThreshold(2500);
+  for(auto &c : catNames) ht.addCategory(c);
+
+  int hPt(ht.getHandle("pt")), hMll(ht.getHandle("mll")), hEtaPhi(ht.getHandle("etaphi")), hRows(ht.getHandle("rows"));
+  vector<HistTool::CategoryMask> masks;
+  for(size_t i=0; i<catNames.size(); i++) masks.push_back(ht.categoryMask(vector<TString>{catNames[i%3],catNames[i]}));
+
+  auto fillEvent=[&](HistShard &shard, size_t iev, vector<double> &steps, vector<double> &weights) {
+    EventRandom rng(iev);
+    HistTool::CategoryMask mask(masks[rng.next()%masks.size()]);
+    double w(0.5+rng.uniform(job.dyadic));
+    shard.fill(hPt,mask,250*rng.uniform(job.dyadic),w);
+    shard.fill(hMll,mask,10+220*rng.uniform(job.dyadic),w);
+    shard.fill2D(hEtaPhi,mask,-2.5+5*rng.uniform(job.dyadic),-3.25+6.5*rng.uniform(job.dyadic),w);
+    steps.clear();
+    for(int s=0; s<5; s++) if(rng.uniform(job.dyadic)<0.5) steps.push_back(s);
+    for(auto &mew : weights) mew=w+(rng.uniform(job.dyadic)-0.5)/8;
+    shard.fillRows(hRows,mask,steps,weights);
+  };
+
+  vector<HistShard> shards(ht.makeShards(job.nShards));
+  atomic<size_t> nextEvent(0);
+  const size_t chunk(16);
+  vector<thread> workers;
+  for(size_t ishard=0; ishard<job.nShards; ishard++) {
+    workers.push_back(thread([&,ishard](){
+      vector<double> steps, weights(10);
+      if(job.dynamic) {
+        for(size_t first=nextEvent.fetch_add(chunk); first<job.nEvents; first=nextEvent.fetch_add(chunk))
+          for(size_t iev=first; iev<min(first+chunk,job.nEvents); iev++)
+            fillEvent(shards[ishard],iev,steps,weights);
+      }
+      else {
+        for(size_t iev=ishard*job.nEvents/job.nShards; iev<(ishard+1)*job.nEvents/job.nShards; iev++)
+          fillEvent(shards[ishard],iev,steps,weights);
+      }
+    }));
+  }
+  for(auto &w : workers) w.join();
+  ht.merge(shards);
+  return snapshot(ht);
+}
+
+int main(int argc, char* argv[])
+{
+  TH1::AddDirectory(kFALSE);
+  size_t nShards(argc>1 ? atoi(argv[1]) : 7), nRuns(argc>2 ? atoi(argv[2]) : 10), nEvents(50000);
+  int nFailed(0);
+
+  //fixed slices: bit-identical from one run to the next
+  Job_t fixed={nShards,nEvents,false,false};
+  Snapshot_t ref(run(fixed));
+  size_t nDiffer(0);
+  for(size_t irun=1; irun<nRuns; irun++) nDiffer += (maxRelDiff(run(fixed),ref)!=0.);
+  cout << "fixed slices, " << nShards << " shards: " << nDiffer << "/" << nRuns-1 << " runs differ from the first one" << endl;
+  if(nDiffer) nFailed++;
+
+  //events on demand: same as a single shard
+  for(bool dyadic : {true,false}) {
+    double tolerance(dyadic ? 0. : 1e-5);
+    Snapshot_t single(run(Job_t{1,nEvents,true,dyadic}));
+    double worst(0.);
+    for(size_t irun=0; irun<nRuns; irun++) worst=max(worst,maxRelDiff(run(Job_t{nShards,nEvents,true,dyadic}),single));
+    cout << "events on demand, " << nShards << " shards, " << (dyadic ? "exact sums" : "any weights")
+         << ": max. relative difference to a single shard " << worst << " (tolerance " << tolerance << ")" << endl;
+    if(worst>tolerance) nFailed++;
+  }
+
+  return nFailed==0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+//
+// HistTool (include/HistTool.h) against direct TH1/TH2 fills: the histograms returned by getPlots and those
+// written by HistTool::write must be identical to those filled directly, bin by bin (contents and errors),
+// with the same Sumw2 presence, number of entries and statistics (GetStats), compared bit for bit
+//
+// compile and run from the package directory:
+//   g++ -std=c++17 -I$CMSSW_BASE/src `root-config --cflags --libs` test/testHistToolFill.cc -o testHistToolFill
+//   ./testHistToolFill
+//
+
+#include "HeavyIonsAnalysis/topskim/include/HistTool.h"
+
+#include "TH1.h"
+#include "TH2.h"
+#include "TMemFile.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+struct Fill_t { double x, y, w; };
+
+//the registered histogram and its category copy are compared with the direct fills
+const TString category("cat");
+
+int compare(const TString &what, TH1 *direct, TH1 *tool)
+{
+  int nDiff(0);
+  auto differs=[&](const TString &qty, double a, double b) {
+    if(a==b) return;
+    if(nDiff<5) cout << "\t " << what << " " << qty << ": direct=" << a << " HistTool=" << b << endl;
+    nDiff++;
+  };
+  if(!tool) {
+    cout << "\t " << what << " not found in HistTool" << endl;
+    return 1;
+  }
+  differs("cells",direct->GetNcells(),tool->GetNcells());
+  differs("Sumw2 size",direct->GetSumw2N(),tool->GetSumw2N());
+  differs("entries",direct->GetEntries(),tool->GetEntries());
+  double sDirect[13]={0}, sTool[13]={0};
+  direct->GetStats(sDirect);
+  tool->GetStats(sTool);
+  for(int i=0; i<13; i++) differs(Form("stats[%d]",i),sDirect[i],sTool[i]);
+  for(int i=0; i<min(direct->GetNcells(),tool->GetNcells()); i++) {
+    differs(Form("content[%d]",i),direct->GetBinContent(i),tool->GetBinContent(i));
+    differs(Form("error[%d]",i),direct->GetBinError(i),tool->GetBinError(i));
+  }
+  cout << what << ": " << (nDiff ? "DIFFERENT" : "identical") << endl;
+  return nDiff ? 1 : 0;
+}
+
+//registers a copy of proto, the labels are set after addHist as for fidcounter in make2Ltree
+int book(HistTool &ht, const TString &what, const TH1 *proto, const vector<TString> &labels, size_t sparseThreshold)
+{
+  ht.setSparseThreshold(sparseThreshold);
+  int h(ht.addHist(what,(TH1 *)proto->Clone(what)));
+  TH1 *registered(proto->GetDimension()==2 ? (TH1 *)ht.get2dPlots()[what] : ht.getPlots()[what]);
+  for(size_t i=0; i<labels.size(); i++) registered->GetXaxis()->SetBinLabel(i+1,labels[i]);
+  return h;
+}
+
+//compares the registered histogram and its category copy with the direct fills, from getPlots and after write
+int compareAll(const TString &what, TH1 *direct, HistTool &ht, HistTool &written)
+{
+  bool is2D(direct->GetDimension()==2);
+  int nFailed(0);
+  for(auto name : {what,category+"_"+what})
+    nFailed += compare(name,direct,is2D ? (TH1 *)ht.get2dPlots()[name] : ht.getPlots()[name]);
+  TMemFile out("testHistToolFill.root","RECREATE");
+  written.write(&out);
+  for(auto name : {what,category+"_"+what})
+    nFailed += compare(name+" (written)",direct,(TH1 *)out.Get(name));
+  return nFailed;
+}
+
+//fills a copy of proto directly and through HistTool, in the registered histogram and one category
+int check(const TString &what, TH1 *proto, const vector<Fill_t> &fills,
+          const vector<TString> &labels=vector<TString>(), size_t sparseThreshold=0)
+{
+  bool is2D(proto->GetDimension()==2);
+  TH1 *direct=(TH1 *)proto->Clone(what+"_direct");
+  for(size_t i=0; i<labels.size(); i++) direct->GetXaxis()->SetBinLabel(i+1,labels[i]);
+  for(auto &f : fills) {
+    if(is2D) ((TH2 *)direct)->Fill(f.x,f.y,f.w);
+    else     direct->Fill(f.x,f.w);
+  }
+
+  HistTool ht, written;
+  for(auto *tool : {&ht,&written}) {
+    int h(book(*tool,what,proto,labels,sparseThreshold));
+    HistTool::CategoryMask mask(tool->categoryMask("")|tool->categoryMask(category));
+    for(auto &f : fills) {
+      if(is2D) tool->fill2D(h,mask,f.x,f.y,f.w);
+      else     tool->fill(h,mask,f.x,f.w);
+    }
+  }
+  return compareAll(what,direct,ht,written);
+}
+
+int main()
+{
+  TH1::AddDirectory(kFALSE);
+  mt19937 rng(42);
+  uniform_real_distribution<double> uni(0,1);
+  int nFailed(0);
+
+  //unit weights first (no Sumw2 until the first weight different from 1), then weighted, with under/overflows
+  vector<Fill_t> fills;
+  for(int i=0; i<2000; i++) fills.push_back(Fill_t{-20+240*uni(rng),-3.5+7*uni(rng),1.});
+  for(int i=0; i<2000; i++) fills.push_back(Fill_t{-20+240*uni(rng),-3.5+7*uni(rng),0.2+1.7*uni(rng)});
+  nFailed += check("unitThenWeighted",new TH1F("unitThenWeighted",";p_{T};Events",20,0,200),fills);
+  nFailed += check("unitThenWeightedD",new TH1D("unitThenWeightedD",";p_{T};Events",20,0,200),fills);
+  nFailed += check("unitThenWeighted2D",new TH2F("unitThenWeighted2D",";p_{T};#eta",20,0,200,12,-3,3),fills);
+
+  //only unit weights: no Sumw2
+  vector<Fill_t> unitFills(fills.begin(),fills.begin()+2000);
+  nFailed += check("unitOnly",new TH1F("unitOnly",";p_{T};Events",20,0,200),unitFills);
+
+  //variable bins in x and y
+  const double xEdges[]={0,10,20,30,50,80,120,200};
+  const double yEdges[]={-3,-2.1,-1.2,0,1.2,2.1,3};
+  nFailed += check("variable",new TH1F("variable",";p_{T};Events",7,xEdges),fills);
+  nFailed += check("variable2D",new TH2F("variable2D",";p_{T};#eta",7,xEdges,6,yEdges),fills);
+
+  //large 2D map stored sparsely
+  nFailed += check("sparse2D",new TH2F("sparse2D",";p_{T};#eta",200,0,200,60,-3,3),fills,vector<TString>(),2500);
+
+  //fully labelled axis filled with numeric values, as ratevsrun (one label per run)
+  vector<TString> runs;
+  for(int i=0; i<8; i++) runs.push_back(Form("%d",326381+i));
+  vector<Fill_t> runFills;
+  for(int i=0; i<3000; i++) runFills.push_back(Fill_t{-1+10*uni(rng),0.,1./(0.5+uni(rng))});
+  nFailed += check("ratevsrun",new TH1F("ratevsrun",";Run number; #sigma [#mub];",runs.size(),0,runs.size()),runFills,runs);
+
+  //fidcounter: labelled steps in x and one row per ME weight, fillRows against the per-weight fill2D loop
+  vector<TString> steps={"all","=2l","=2l fid","=2l,#geq1b fid","=2l,#geq2b fid"};
+  const size_t nWeights(30);
+  TH2F *fidProto=new TH2F("fidcounter",";Fiducial counter;Events",steps.size(),0,steps.size(),nWeights,0,nWeights);
+  TH2F *fidDirect=(TH2F *)fidProto->Clone("fidcounter_direct");
+  for(size_t i=0; i<steps.size(); i++) fidDirect->GetXaxis()->SetBinLabel(i+1,steps[i]);
+  HistTool ht, written;
+  int hFid(book(ht,"fidcounter",fidProto,steps,0)), hFidWritten(book(written,"fidcounter",fidProto,steps,0));
+  HistTool::CategoryMask fidMask(ht.categoryMask("")|ht.categoryMask(category));
+  HistTool::CategoryMask fidMaskWritten(written.categoryMask("")|written.categoryMask(category));
+  for(int iev=0; iev<2000; iev++) {
+    vector<double> x={0.}, w(nWeights);
+    for(int s=1; s<int(steps.size()); s++) if(uni(rng)<0.6) x.push_back(s);
+    for(size_t i=0; i<nWeights; i++) w[i] = iev<500 ? 1. : 0.5+uni(rng);
+    for(size_t i=0; i<nWeights; i++)
+      for(auto xj : x) fidDirect->Fill(xj,i,w[i]);
+    ht.fillRows(hFid,fidMask,x,w);
+    written.fillRows(hFidWritten,fidMaskWritten,x,w);
+  }
+  nFailed += compareAll("fidcounter",fidDirect,ht,written);
+
+  return nFailed==0 ? 0 : 1;
+}
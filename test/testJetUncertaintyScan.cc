@@ -0,0 +1,108 @@
+//
+// dense scan of JetUncertainty: the binary search used for files binned only in eta (EtaOnly)
+// must find the same entry as the linear search over all the bins
+//
+// the linear search is forced by loading the same file with a dummy JetPt bin [0,1e30] added to each entry
+// compile and run from the package directory:
+//   g++ -std=c++17 -I$CMSSW_BASE/src `root-config --cflags --libs` test/testJetUncertaintyScan.cc -o testJetUncertaintyScan
+//   ./testJetUncertaintyScan [uncertainty files]
+//
+
+#include "HeavyIonsAnalysis/topskim/include/JetUncertainty.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//rewrites a {1 JetEta ...} file as {2 JetEta JetPt ...} with the full pt range for each entry
+string addDummyPtBin(const string &url)
+{
+  ifstream in(url.c_str());
+  stringstream out;
+  string line;
+  while(getline(in,line)) {
+    if(line.find('{')!=string::npos) {
+      size_t pos(line.find("JetEta"));
+      if(pos!=string::npos) line.replace(pos,6,"JetEta JetPt");
+      line.replace(line.find('1'),1,"2");
+    }
+    else {
+      stringstream tkns(line);
+      string etaLo,etaHi,rest;
+      if(!(tkns >> etaLo >> etaHi)) continue;
+      getline(tkns,rest);
+      line=etaLo+" "+etaHi+" 0 1e30"+rest;
+    }
+    out << line << endl;
+  }
+  return out.str();
+}
+
+int main(int argc, char* argv[])
+{
+  vector<string> urls;
+  for(int i=1; i<argc; i++) urls.push_back(argv[i]);
+  if(urls.empty()) {
+    for(string v : {"V1","V4","V6"})
+      for(string s : {"DATA","MC"})
+        urls.push_back("data/Autumn18_HI_"+v+"_"+s+"_Uncertainty_AK4PF.txt");
+  }
+
+  int nFailed(0);
+  for(auto &url : urls) {
+
+    ifstream fin(url.c_str());
+    if(!fin.good()) { cout << url << " not found" << endl; nFailed++; continue; }
+    JetUncertainty fast, linear;
+    fast.Initialize(fin);
+    stringstream lin(addDummyPtBin(url));
+    linear.Initialize(lin);
+    if(!fast.IsEtaOnly() || linear.IsEtaOnly()) {
+      cout << url << " EtaOnly=" << fast.IsEtaOnly() << " (expected 1), dummy pt bin EtaOnly=" << linear.IsEtaOnly() << " (expected 0)" << endl;
+      nFailed++;
+      continue;
+    }
+
+    //eta: a fine grid beyond the file range, every bin edge and its neighbouring floats
+    vector<double> etas;
+    for(double eta=-6; eta<=6; eta+=1e-3) etas.push_back(eta);
+    for(size_t iE=0; iE<fast.GetEtaLow().size(); iE++) {
+      for(double edge : {fast.GetEtaLow()[iE],fast.GetEtaHigh()[iE]}) {
+        etas.push_back(edge);
+        etas.push_back(nextafter(edge,-1e9));
+        etas.push_back(nextafter(edge,1e9));
+      }
+    }
+
+    //pt: below, on and between the nodes of the first entry and a log grid up to very high pt
+    vector<double> pts;
+    for(double pt=1; pt<1e4; pt*=1.01) pts.push_back(pt);
+    for(auto pt : fast.GetPTNodes(0)) { pts.push_back(pt); pts.push_back(nextafter(pt,0.)); }
+
+    size_t nChecked(0),nDiff(0);
+    for(auto eta : etas) {
+      vector<double> etaVec(pts.size(),eta);
+      vector<pair<double,double> > fastUnc(fast.GetUncertainties(pts,etaVec));
+      vector<pair<double,double> > linUnc(linear.GetUncertainties(pts,etaVec));
+      for(size_t i=0; i<pts.size(); i++) {
+        nChecked++;
+        if(fastUnc[i]==linUnc[i]) continue;
+        if(nDiff<10)
+          cout << "\t pt=" << pts[i] << " eta=" << eta
+               << " EtaOnly=(" << fastUnc[i].first << "," << fastUnc[i].second << ")"
+               << " linear=(" << linUnc[i].first << "," << linUnc[i].second << ")" << endl;
+        nDiff++;
+      }
+    }
+
+    cout << url << ": " << nChecked << " points, " << nDiff << " differences" << endl;
+    if(nDiff) nFailed++;
+  }
+
+  return nFailed==0 ? 0 : 1;
+}
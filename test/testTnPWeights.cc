@@ -0,0 +1,137 @@
+//
+// scan of the table-driven muon tag-and-probe scale factors (include/tnp_weight.h)
+// against the original if-else implementation (test/tnp_weight_reference.h), for every idx
+//
+// compile and run from the package directory:
+//   g++ -std=c++17 -I$CMSSW_BASE/src `root-config --cflags --libs` test/testTnPWeights.cc -o testTnPWeights
+//   ./testTnPWeights
+//
+
+#include "HeavyIonsAnalysis/topskim/include/tnp_weight.h"
+#include "HeavyIonsAnalysis/topskim/test/tnp_weight_reference.h"
+
+#include "TString.h"
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//the variations, the undefined indices in both ranges, and the data/MC efficiencies
+const vector<int> idxList = { -5, -3, -2, -1, 0, 1, 2, 3, 5, 10, 11, 12, 199, 200, 300, 301 };
+
+//values and their neighbouring floats
+vector<double> withNeighbours(const vector<double> &vals)
+{
+  vector<double> out;
+  for(auto v : vals) {
+    out.push_back(v);
+    out.push_back(nextafter(v,-1e9));
+    out.push_back(nextafter(v,1e9));
+  }
+  return out;
+}
+
+//a regular grid plus the given edges and their neighbours
+vector<double> grid(double min, double max, double step, const vector<double> &edges)
+{
+  vector<double> out(withNeighbours(edges));
+  for(double x=min; x<=max+1e-9; x+=step) out.push_back(x);
+  return out;
+}
+
+struct Result_t {
+  size_t nChecked, nDiff;
+  double maxRelDiff;
+};
+
+//compares the two implementations, the reference is called with std::cout muted (it prints out-of-range inputs)
+void compare(Result_t &res, const string &what, double val, double ref)
+{
+  res.nChecked++;
+  double relDiff(fabs(val-ref)/max(fabs(ref),1e-12));
+  res.maxRelDiff=max(res.maxRelDiff,relDiff);
+  if(relDiff<1e-12) return;
+  if(res.nDiff<10) cout << "\t " << what << " table=" << val << " reference=" << ref << endl;
+  res.nDiff++;
+}
+
+double muted(function<double()> f)
+{
+  stringstream sink;
+  streambuf *prev=cout.rdbuf(sink.rdbuf());
+  double val(f());
+  cout.rdbuf(prev);
+  return val;
+}
+
+int main()
+{
+  int nFailed(0);
+  auto summary=[&nFailed](const string &name, const Result_t &res) {
+    cout << name << ": " << res.nChecked << " values, " << res.nDiff << " differences"
+         << " (max relative difference " << res.maxRelDiff << ")" << endl;
+    if(res.nDiff) nFailed++;
+  };
+
+  vector<double> glbtrkEta(grid(-2.6,2.6,0.01,vector<double>(tnp_tables::glbtrkEtaEdges,tnp_tables::glbtrkEtaEdges+tnp_tables::glbtrkNEta+1)));
+  vector<double> muidEta(grid(-2.6,2.6,0.01,vector<double>(tnp_tables::muidEtaEdges,tnp_tables::muidEtaEdges+tnp_tables::muidNEta+1)));
+  vector<double> trigEta(grid(-2.6,2.6,0.05,{-2.4,-2.1,-1.2,0,1.2,2.1,2.4}));
+  vector<double> cents(grid(-5,105,2.5,{0,10,20,40,100}));
+  vector<double> trigPt(grid(5,120,2.5,{15,20,30,50,80,9999}));
+
+  //global track
+  Result_t glbtrk={0,0,0.};
+  for(auto eta : glbtrkEta)
+    for(auto cent : cents)
+      for(auto idx : idxList) {
+        double val(tnp_weight_glbtrk_pbpb(eta,cent,idx));
+        double ref(muted([&]{ return tnp_reference::tnp_weight_glbtrk_pbpb(eta,cent,idx); }));
+        compare(glbtrk,Form("glbtrk eta=%.17g cent=%.17g idx=%d",eta,cent,idx),val,ref);
+      }
+  summary("tnp_weight_glbtrk_pbpb",glbtrk);
+
+  //muon id
+  Result_t muid={0,0,0.};
+  for(auto eta : muidEta)
+    for(auto idx : idxList) {
+      double val(tnp_weight_muid_pbpb(eta,idx));
+      double ref(muted([&]{ return tnp_reference::tnp_weight_muid_pbpb(eta,idx); }));
+      compare(muid,Form("muid eta=%.17g idx=%d",eta,idx),val,ref);
+    }
+  summary("tnp_weight_muid_pbpb",muid);
+
+  //trigger
+  Result_t trig={0,0,0.};
+  for(auto pt : trigPt)
+    for(auto eta : trigEta)
+      for(auto cent : cents)
+        for(auto idx : idxList) {
+          double val(tnp_weight_trig_pbpb(pt,eta,cent,idx));
+          double ref(muted([&]{ return tnp_reference::tnp_weight_trig_pbpb(pt,eta,cent,idx); }));
+          compare(trig,Form("trig pt=%.17g eta=%.17g cent=%.17g idx=%d",pt,eta,cent,idx),val,ref);
+        }
+  summary("tnp_weight_trig_pbpb",trig);
+
+  //quirks of the original implementation which are kept on purpose
+  Result_t quirks={0,0,0.};
+  for(auto pt : trigPt)
+    for(auto eta : trigEta)
+      for(auto cent : cents) {
+        double nominal(tnp_weight_trig_pbpb(pt,eta,cent,0));
+        compare(quirks,Form("trig syst up = nominal pt=%g eta=%g cent=%g",pt,eta,cent),tnp_weight_trig_pbpb(pt,eta,cent,-1),nominal);
+        compare(quirks,Form("trig syst down = nominal pt=%g eta=%g cent=%g",pt,eta,cent),tnp_weight_trig_pbpb(pt,eta,cent,-2),nominal);
+      }
+  for(auto eta : glbtrkEta)
+    for(auto cent : cents) {
+      if(cent<40 || cent>100) continue;
+      compare(quirks,Form("glbtrk effData = 1 eta=%g cent=%g",eta,cent),tnp_weight_glbtrk_pbpb(eta,cent,200),1.);
+    }
+  summary("preserved quirks (trigger syst = nominal, glbtrk data efficiency = 1 for cent>=40)",quirks);
+
+  return nFailed==0 ? 0 : 1;
+}